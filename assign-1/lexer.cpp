@@ -0,0 +1,270 @@
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "scan.cpp"
+
+#ifndef LEXER_CPP
+#define LEXER_CPP
+
+// Token kinds produced by the lexer. Everything up to and including Error is a
+// real token and is printed by name; the trivia kinds after it are skipped.
+enum class TokenKind : uint8_t {
+    Num, Id,
+    Int, Struct, Nil, Break, Continue, Return, If, Else, While, New, Let, Extern, Fn,
+    Address, Colon, Semicolon, Comma, Underscore, Arrow, Plus, Dash, Star, Slash,
+    Equal, NotEq, Lt, Lte, Gt, Gte, Dot, Gets,
+    OpenParen, CloseParen, OpenBracket, CloseBracket, OpenBrace, CloseBrace,
+    Error,
+    Whitespace, LineComment, BlockComment, UnclosedComment,
+    End
+};
+
+inline const char* tokenKindName(TokenKind kind) {
+    static const char* const names[] = {
+        "Num", "Id",
+        "Int", "Struct", "Nil", "Break", "Continue", "Return", "If", "Else", "While", "New", "Let", "Extern", "Fn",
+        "Address", "Colon", "Semicolon", "Comma", "Underscore", "Arrow", "Plus", "Dash", "Star", "Slash",
+        "Equal", "NotEq", "Lt", "Lte", "Gt", "Gte", "Dot", "Gets",
+        "OpenParen", "CloseParen", "OpenBracket", "CloseBracket", "OpenBrace", "CloseBrace",
+        "Error",
+        "whitespace", "c++-comment", "c-comment", "unclosed-c-comment",
+        "End"
+    };
+    return names[static_cast<uint8_t>(kind)];
+}
+
+inline bool isTrivia(TokenKind kind) { return kind >= TokenKind::Whitespace && kind != TokenKind::End; }
+inline bool hasLexeme(TokenKind kind) { return kind == TokenKind::Id || kind == TokenKind::Num; }
+
+// A token is a kind plus a view of its lexeme in the input buffer; nothing is copied.
+struct Token {
+    TokenKind kind = TokenKind::End;
+    std::string_view text;
+};
+
+namespace lexer_tables {
+
+// Every byte is mapped to one of these classes before it hits the DFA.
+enum CharClass : uint8_t {
+    C_Other, C_Digit, C_Alpha, C_Space, C_Newline,
+    C_Slash, C_Star, C_Dash, C_Gt, C_Lt, C_Eq, C_Bang,
+    C_Amp, C_Colon, C_Semi, C_Comma, C_Under, C_Plus, C_Dot,
+    C_LParen, C_RParen, C_LBrack, C_RBrack, C_LBrace, C_RBrace,
+    NumClasses
+};
+
+// DFA states. S_Dead stops the scan; every other state is accepting, so maximal
+// munch never has to back up (e.g. `!` alone is an Error, `/*` alone is unclosed).
+enum State : uint8_t {
+    S_Dead, S_Start,
+    S_Num, S_Id, S_Ws, S_Slash, S_LineComment, S_Block, S_BlockStar, S_BlockDone,
+    S_Dash, S_Eq, S_Bang, S_Lt, S_Gt,
+    S_Arrow, S_Equal, S_NotEq, S_Lte, S_Gte,
+    S_Address, S_Colon, S_Semicolon, S_Comma, S_Underscore, S_Plus, S_Star, S_Dot,
+    S_OpenParen, S_CloseParen, S_OpenBracket, S_CloseBracket, S_OpenBrace, S_CloseBrace,
+    S_Error,
+    NumStates
+};
+
+using ClassTable = std::array<uint8_t, 256>;
+using TransitionTable = std::array<std::array<uint8_t, NumClasses>, NumStates>;
+using AcceptTable = std::array<TokenKind, NumStates>;
+
+constexpr ClassTable makeClassTable() {
+    ClassTable t{};
+    for (int c = '0'; c <= '9'; c++) t[c] = C_Digit;
+    for (int c = 'a'; c <= 'z'; c++) t[c] = C_Alpha;
+    for (int c = 'A'; c <= 'Z'; c++) t[c] = C_Alpha;
+    t[' '] = C_Space; t['\t'] = C_Space; t['\r'] = C_Space; t['\n'] = C_Newline;
+    t['/'] = C_Slash; t['*'] = C_Star; t['-'] = C_Dash; t['>'] = C_Gt; t['<'] = C_Lt;
+    t['='] = C_Eq; t['!'] = C_Bang; t['&'] = C_Amp; t[':'] = C_Colon; t[';'] = C_Semi;
+    t[','] = C_Comma; t['_'] = C_Under; t['+'] = C_Plus; t['.'] = C_Dot;
+    t['('] = C_LParen; t[')'] = C_RParen; t['['] = C_LBrack; t[']'] = C_RBrack;
+    t['{'] = C_LBrace; t['}'] = C_RBrace;
+    return t;
+}
+
+constexpr TransitionTable makeTransitionTable() {
+    TransitionTable t{}; // everything defaults to S_Dead
+    auto& start = t[S_Start];
+    for (auto& s: start) s = S_Error;
+    start[C_Digit] = S_Num; start[C_Alpha] = S_Id;
+    start[C_Space] = S_Ws; start[C_Newline] = S_Ws;
+    start[C_Slash] = S_Slash; start[C_Star] = S_Star; start[C_Dash] = S_Dash;
+    start[C_Gt] = S_Gt; start[C_Lt] = S_Lt; start[C_Eq] = S_Eq; start[C_Bang] = S_Bang;
+    start[C_Amp] = S_Address; start[C_Colon] = S_Colon; start[C_Semi] = S_Semicolon;
+    start[C_Comma] = S_Comma; start[C_Under] = S_Underscore; start[C_Plus] = S_Plus;
+    start[C_Dot] = S_Dot; start[C_LParen] = S_OpenParen; start[C_RParen] = S_CloseParen;
+    start[C_LBrack] = S_OpenBracket; start[C_RBrack] = S_CloseBracket;
+    start[C_LBrace] = S_OpenBrace; start[C_RBrace] = S_CloseBrace;
+
+    t[S_Num][C_Digit] = S_Num;
+    t[S_Id][C_Alpha] = S_Id; t[S_Id][C_Digit] = S_Id;
+    t[S_Ws][C_Space] = S_Ws; t[S_Ws][C_Newline] = S_Ws;
+
+    t[S_Slash][C_Slash] = S_LineComment;
+    t[S_Slash][C_Star] = S_Block;
+    for (auto& s: t[S_LineComment]) s = S_LineComment;
+    t[S_LineComment][C_Newline] = S_Dead;
+    for (auto& s: t[S_Block]) s = S_Block;
+    t[S_Block][C_Star] = S_BlockStar;
+    for (auto& s: t[S_BlockStar]) s = S_Block;
+    t[S_BlockStar][C_Star] = S_BlockStar;
+    t[S_BlockStar][C_Slash] = S_BlockDone;
+
+    t[S_Dash][C_Gt] = S_Arrow;
+    t[S_Eq][C_Eq] = S_Equal;
+    t[S_Bang][C_Eq] = S_NotEq;
+    t[S_Lt][C_Eq] = S_Lte;
+    t[S_Gt][C_Eq] = S_Gte;
+    return t;
+}
+
+constexpr AcceptTable makeAcceptTable() {
+    AcceptTable t{};
+    for (auto& k: t) k = TokenKind::Error;
+    t[S_Dead] = TokenKind::End;
+    t[S_Num] = TokenKind::Num; t[S_Id] = TokenKind::Id; t[S_Ws] = TokenKind::Whitespace;
+    t[S_Slash] = TokenKind::Slash; t[S_LineComment] = TokenKind::LineComment;
+    t[S_Block] = TokenKind::UnclosedComment; t[S_BlockStar] = TokenKind::UnclosedComment;
+    t[S_BlockDone] = TokenKind::BlockComment;
+    t[S_Dash] = TokenKind::Dash; t[S_Eq] = TokenKind::Gets; t[S_Bang] = TokenKind::Error;
+    t[S_Lt] = TokenKind::Lt; t[S_Gt] = TokenKind::Gt;
+    t[S_Arrow] = TokenKind::Arrow; t[S_Equal] = TokenKind::Equal; t[S_NotEq] = TokenKind::NotEq;
+    t[S_Lte] = TokenKind::Lte; t[S_Gte] = TokenKind::Gte;
+    t[S_Address] = TokenKind::Address; t[S_Colon] = TokenKind::Colon; t[S_Semicolon] = TokenKind::Semicolon;
+    t[S_Comma] = TokenKind::Comma; t[S_Underscore] = TokenKind::Underscore; t[S_Plus] = TokenKind::Plus;
+    t[S_Star] = TokenKind::Star; t[S_Dot] = TokenKind::Dot;
+    t[S_OpenParen] = TokenKind::OpenParen; t[S_CloseParen] = TokenKind::CloseParen;
+    t[S_OpenBracket] = TokenKind::OpenBracket; t[S_CloseBracket] = TokenKind::CloseBracket;
+    t[S_OpenBrace] = TokenKind::OpenBrace; t[S_CloseBrace] = TokenKind::CloseBrace;
+    return t;
+}
+
+inline constexpr ClassTable charClass = makeClassTable();
+inline constexpr TransitionTable transition = makeTransitionTable();
+inline constexpr AcceptTable accept = makeAcceptTable();
+
+}
+
+namespace keyword_tables {
+
+// Keywords are told apart by a perfect hash of (first char + last char + length) mod 32,
+// so classifying an identifier is one table probe and at most one compare.
+struct Entry {
+    std::string_view word;
+    TokenKind kind = TokenKind::Id;
+};
+
+inline constexpr Entry keywords[] = {
+    {"int", TokenKind::Int}, {"struct", TokenKind::Struct}, {"nil", TokenKind::Nil}, {"break", TokenKind::Break},
+    {"continue", TokenKind::Continue}, {"return", TokenKind::Return}, {"if", TokenKind::If}, {"else", TokenKind::Else},
+    {"while", TokenKind::While}, {"new", TokenKind::New}, {"let", TokenKind::Let}, {"extern", TokenKind::Extern}, {"fn", TokenKind::Fn}
+};
+constexpr std::size_t minLength = 2;
+constexpr std::size_t maxLength = 8;
+
+constexpr std::size_t hash(std::string_view word) {
+    return (static_cast<unsigned char>(word.front()) + static_cast<unsigned char>(word.back()) + word.size()) & 31;
+}
+
+constexpr std::array<Entry, 32> makeTable() {
+    std::array<Entry, 32> t{};
+    for (const Entry& e: keywords) t[hash(e.word)] = e;
+    return t;
+}
+
+inline constexpr std::array<Entry, 32> table = makeTable();
+
+constexpr bool isPerfect() {
+    for (const Entry& e: keywords) {
+        if (table[hash(e.word)].word != e.word) return false;
+    }
+    return true;
+}
+static_assert(isPerfect(), "keyword hash has a collision");
+
+}
+
+constexpr TokenKind keywordKind(std::string_view word) {
+    using namespace keyword_tables;
+    if (word.size() < minLength || word.size() > maxLength) return TokenKind::Id;
+    const Entry& e = table[hash(word)];
+    return (e.word == word) ? e.kind : TokenKind::Id;
+}
+static_assert(keywordKind("continue") == TokenKind::Continue && keywordKind("fn") == TokenKind::Fn, "keyword lookup");
+static_assert(keywordKind("fnord") == TokenKind::Id && keywordKind("i") == TokenKind::Id, "identifier lookup");
+
+struct Lexer {
+    std::string_view input;
+    std::size_t pos = 0;
+    const scan::Kernels* kernels = &scan::best();
+
+    explicit Lexer(std::string_view input) : input(input) {}
+
+    // Scans the lexeme starting at pos by running the DFA until it dies.
+    // Whitespace, comments and identifiers are long runs in practice, so those are
+    // skipped with the SIMD kernels first; they stop exactly where the DFA would.
+    // Trivia (whitespace and comments) is returned like any other token.
+    Token scan() {
+        using namespace lexer_tables;
+        const std::size_t n = input.size();
+        if (pos >= n) return Token{TokenKind::End, input.substr(n)};
+        const std::size_t start = pos;
+        const char* p = input.data();
+        switch (charClass[static_cast<unsigned char>(p[pos])]) {
+            case C_Space:
+            case C_Newline:
+                pos = kernels->skipWhitespace(p, pos + 1, n);
+                return Token{TokenKind::Whitespace, input.substr(start, pos - start)};
+            case C_Alpha: {
+                pos = kernels->skipAlnum(p, pos + 1, n);
+                std::string_view text = input.substr(start, pos - start);
+                return Token{keywordKind(text), text};
+            }
+            case C_Slash:
+                if (pos + 1 < n && p[pos+1] == '/') {
+                    pos = kernels->findNewline(p, pos + 2, n);
+                    return Token{TokenKind::LineComment, input.substr(start, pos - start)};
+                }
+                if (pos + 1 < n && p[pos+1] == '*') {
+                    std::size_t end = kernels->findBlockEnd(p, pos + 2, n);
+                    pos = (end < n) ? end + 2 : n;
+                    return Token{(end < n) ? TokenKind::BlockComment : TokenKind::UnclosedComment, input.substr(start, pos - start)};
+                }
+                break;
+        }
+        uint8_t state = transition[S_Start][charClass[static_cast<unsigned char>(p[pos++])]];
+        while (pos < n) {
+            const uint8_t next = transition[state][charClass[static_cast<unsigned char>(p[pos])]];
+            if (next == S_Dead) break;
+            state = next;
+            pos++;
+        }
+        std::string_view text = input.substr(start, pos - start);
+        TokenKind kind = accept[state];
+        if (kind == TokenKind::Id) kind = keywordKind(text);
+        return Token{kind, text};
+    }
+
+    // Next token that the parser cares about; End once the input is exhausted.
+    Token next() {
+        Token t = scan();
+        while (isTrivia(t.kind)) t = scan();
+        return t;
+    }
+};
+
+// Appends a token in the text format shared by the lexer and parser, e.g. `Id(foo)` or `Arrow`.
+inline void appendTokenText(std::string& out, const Token& t) {
+    out += tokenKindName(t.kind);
+    if (hasLexeme(t.kind)) {
+        out += '(';
+        out += t.text;
+        out += ')';
+    }
+    out += '\n';
+}
+
+#endif
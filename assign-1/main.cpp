@@ -1,125 +1,86 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <memory>
 #include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
 #include <vector>
-#include <unordered_map>
+#include "lexer.cpp"
+#include "parallel_lexer.cpp"
+#include "source.cpp"
+#include "token_stream.cpp"
 
+// usage: lex [--binary] [-j threads] <file>
+// Writes one token per line to stdout, or the binary token stream with --binary.
+// With -j the input is lexed on that many threads (see parallel_lexer.cpp); the
+// output is the same either way.
 int main(int argc, char** argv) {
-    if (argc < 2) {
+    bool binary = false;
+    unsigned threads = 0;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--binary") binary = true;
+        else if (arg == "-j" && i + 1 < argc) threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        else path = argv[i];
+    }
+    if (!path) {
         std::cerr << "No argument provided\n"; 
         return 1; 
     }
-    std::string input;
+    std::unique_ptr<SourceFile> source;
     try {
-        std::ifstream ifs(argv[1]);
-        std::stringstream buffer;
-        buffer << ifs.rdbuf();
-        input = buffer.str();
+        source = std::make_unique<SourceFile>(path);
     }
     catch(const std::exception& e) {
         std::cerr << "Invalid file\n";
         return 1;
     }
 
-    std::string::size_type i = 0;
-    const std::string::size_type n = input.size();
-    while (i < n) {
-        const char c = input[i];
-        std::string token = "Error";
-        int length = 1;
-        
-        if (isdigit(c)) {
-            std::string::size_type iend = i+1;
-            while (iend < n && isdigit(input[iend])) iend++;
-            length = iend - i;
-            token = "Num";
+    std::ios::sync_with_stdio(false);
+    if (threads) {
+        std::vector<Token> tokens = lexParallel(source->view(), threads);
+        if (binary) {
+            TokenStreamWriter writer;
+            for (const Token& t: tokens) writer.add(t);
+            writer.write(std::cout);
+            return 0;
+        }
+        // Each thread renders a contiguous slice of the tokens; slices are written in order
+        std::vector<std::string> outs(threads);
+        std::vector<std::thread> workers;
+        for (unsigned i = 0; i < threads; i++) {
+            workers.emplace_back([&tokens, &outs, threads, i] {
+                const std::size_t first = tokens.size() / threads * i;
+                const std::size_t last = (i + 1 == threads) ? tokens.size() : tokens.size() / threads * (i + 1);
+                for (std::size_t k = first; k < last; k++) appendTokenText(outs[i], tokens[k]);
+            });
         }
-        
-        else if (isalpha(c)) {
-            std::string::size_type iend = i+1;
-            while (iend < n && (isalpha(input[iend]) || isdigit(input[iend]))) iend++;
-            length = iend - i;
-            static const std::unordered_map<std::string, std::string> tokenMap = {
-                {"int", "Int"}, {"struct", "Struct"}, {"nil", "Nil"}, {"break", "Break"},
-                {"continue", "Continue"}, {"return", "Return"}, {"if", "If"}, {"else", "Else"},
-                {"while", "While"}, {"new", "New"}, {"let", "Let"}, {"extern", "Extern"}, {"fn", "Fn"}
-            };
-            auto it = tokenMap.find(input.substr(i, length));
-            token = (it == tokenMap.end()) ? "Id" : it->second;
+        for (unsigned i = 0; i < threads; i++) {
+            workers[i].join();
+            std::cout.write(outs[i].data(), outs[i].size());
         }
-        
-        switch(c) {
-            case '&': token = "Address"; break;
-            case ':': token = "Colon"; break;
-            case ';': token = "Semicolon"; break;
-            case ',': token = "Comma"; break;
-            case '_': token = "Underscore"; break;
-            case '+': token = "Plus"; break;
-            case '.': token = "Dot"; break;
-            case '(': token = "OpenParen"; break;
-            case ')': token = "CloseParen"; break;
-            case '[': token = "OpenBracket"; break;
-            case ']': token = "CloseBracket"; break;
-            case '{': token = "OpenBrace"; break;
-            case '}': token = "CloseBrace"; break;
-            case '*': token = "Star"; break;
-            case '-': 
-                if (i+1 < n && input[i+1] == '>') { length = 2; token = "Arrow"; }
-                else { token = "Dash"; }
-                break;
-            case '=': 
-                if (i+1 < n && input[i+1] == '=') { length = 2; token = "Equal"; }
-                else { token = "Gets"; }
-                break;            
-            case '!': 
-                if (i+1 < n && input[i+1] == '=') { length = 2; token = "NotEq"; }
-                break;
-            case '<':
-                if (i+1 < n && input[i+1] == '=') { length = 2; token = "Lte"; }
-                else { token = "Lt"; }
-                break;
-            case '>':
-                if (i+1 < n && input[i+1] == '=') { length = 2; token = "Gte"; }
-                else { token = "Gt"; }
-                break;
-            case '/': {
-                if (i+1 < input.length() && input[i+1] == '/') {
-                    std::string::size_type iend = i+2;
-                    while (iend < input.length() && input[iend] != '\n') iend++;
-                    length = iend - i;
-                    token = "c++-comment";
-                }
-                else if (i+1 < input.length() && input[i+1] == '*') {
-                    std::string::size_type iend = i+2;
-                    while (iend < n && !(iend < n-1 && input[iend] == '*' && input[iend+1] == '/')) iend++;
-                    if (iend < n-1 && input[iend] == '*' && input[iend+1] == '/') {
-                        length = iend - i + 2;
-                        token = "c-comment";
-                    }
-                    else {
-                        length = iend - i;
-                        token = "unclosed-c-comment";
-                    }
-                }
-                else { token = "Slash"; }
-                break;
-            }
-            case ' ':
-            case '\t':
-            case '\n':
-            case '\r': {
-                std::string::size_type iend = i+1;
-                while (iend < n && (input[iend] == ' ' || input[iend] == '\t' || input[iend] == '\n' || input[iend] == '\r')) iend++;
-                length = iend - i;
-                token = "whitespace";
-                break;
-            }
+        return 0;
+    }
+
+    Lexer lexer(source->view());
+    if (binary) {
+        TokenStreamWriter writer;
+        for (Token t = lexer.next(); t.kind != TokenKind::End; t = lexer.next()) writer.add(t);
+        writer.write(std::cout);
+        return 0;
+    }
+
+    // Tokens are rendered into a reused buffer and written out in large chunks
+    std::string out;
+    out.reserve(1 << 16);
+    for (Token t = lexer.next(); t.kind != TokenKind::End; t = lexer.next()) {
+        appendTokenText(out, t);
+        if (out.size() >= (1 << 16) - 64) {
+            std::cout.write(out.data(), out.size());
+            out.clear();
         }
-        
-        if (token == "Id" || token == "Num")  std::cout << token << "(" << input.substr(i, length) << ")" << std::endl;
-        else if (token != "whitespace" && token != "c++-comment" && token != "c-comment" && token != "unclosed-c-comment") std::cout << token << std::endl;
-        i += length;
     }
+    std::cout.write(out.data(), out.size());
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "lexer.cpp"
+
+#ifndef PARALLEL_LEXER_CPP
+#define PARALLEL_LEXER_CPP
+
+// Lexes input on several threads and returns exactly the tokens that Lexer::next()
+// would, in order (trivia dropped).
+//
+// The input is cut into one chunk per thread, each cut placed just after a newline,
+// and every chunk is lexed on its own as if it started outside a comment. A chunk
+// keeps the tokens that *start* inside it; its last one may run past the cut. That
+// guess is only wrong when the previous chunk's last token crosses the cut, which
+// for cflat means a /* */ comment (or an identifier/number/operator if the chunk
+// has no newline to cut at). The stitching pass walks the chunks in order, tracking
+// where the sequential lexer would really be. When it lands exactly on a chunk's
+// start, that chunk is taken as is. Otherwise it lexes forward from the real
+// position until it reaches a token start the chunk also produced. From there the
+// two must agree, since the lexer has no state but its position. The rest of
+// that chunk is reused. A comment that swallows whole chunks just skips them.
+struct ParallelLexer {
+    struct Chunk {
+        std::size_t begin = 0, end = 0; // the cut points; tokens starting in [begin, end) belong here
+        std::size_t stop = 0;           // where the last of those tokens ends (>= end unless input ran out)
+        std::vector<Token> tokens;
+    };
+
+    std::string_view input;
+    unsigned threads;
+
+    ParallelLexer(std::string_view input, unsigned threads) : input(input), threads(std::max(1u, threads)) {}
+
+    std::size_t offset(const Token& t) const { return static_cast<std::size_t>(t.text.data() - input.data()); }
+
+    // Cuts after the first newline at or past each i * n / threads
+    std::vector<Chunk> split() const {
+        std::vector<Chunk> chunks;
+        std::size_t begin = 0;
+        for (unsigned i = 1; i <= threads && begin < input.size(); i++) {
+            std::size_t end = input.size();
+            if (i < threads) {
+                std::size_t newline = input.find('\n', std::max(begin, input.size() / threads * i));
+                if (newline != std::string_view::npos) end = newline + 1;
+            }
+            Chunk c;
+            c.begin = begin;
+            c.end = end;
+            chunks.push_back(c);
+            begin = end;
+        }
+        return chunks;
+    }
+
+    void lexChunk(Chunk& c) const {
+        Lexer lexer(input);
+        lexer.pos = c.begin;
+        c.tokens.reserve((c.end - c.begin) / 2); // typical code has a token every 2-3 bytes
+        while (lexer.pos < c.end) {
+            Token t = lexer.scan();
+            if (!isTrivia(t.kind)) c.tokens.push_back(t);
+        }
+        c.stop = lexer.pos;
+    }
+
+    std::vector<Token> run() const {
+        std::vector<Chunk> chunks = split();
+        std::vector<std::thread> workers;
+        for (std::size_t i = 1; i < chunks.size(); i++) workers.emplace_back([this, &chunks, i] { lexChunk(chunks[i]); });
+        if (chunks.empty()) return {};
+        lexChunk(chunks[0]);
+        for (std::thread& w: workers) w.join();
+        if (chunks.size() == 1) return std::move(chunks[0].tokens);
+
+        // Decide, chunk by chunk, which of its tokens survive: a suffix of what it
+        // speculated, preceded by whatever had to be re-lexed to get back in step.
+        std::vector<std::vector<Token>> relexed(chunks.size());
+        std::vector<std::size_t> keepFrom(chunks.size()); // first speculative token kept
+        std::size_t pos = 0; // where the sequential lexer would be
+        for (std::size_t i = 0; i < chunks.size(); i++) {
+            const Chunk& c = chunks[i];
+            keepFrom[i] = c.tokens.size();
+            if (pos >= c.end) continue; // swallowed by a token from an earlier chunk
+            if (pos == c.begin) {
+                keepFrom[i] = 0;
+                pos = c.stop;
+                continue;
+            }
+            Lexer lexer(input);
+            lexer.pos = pos;
+            auto spec = c.tokens.begin(); // first speculative token not before lexer.pos
+            bool synced = false;
+            while (lexer.pos < c.end) {
+                spec = std::lower_bound(spec, c.tokens.end(), lexer.pos, [this](const Token& t, std::size_t p) { return offset(t) < p; });
+                if (spec != c.tokens.end() && offset(*spec) == lexer.pos) {
+                    synced = true;
+                    break;
+                }
+                Token t = lexer.scan();
+                if (!isTrivia(t.kind)) relexed[i].push_back(t);
+            }
+            if (synced) keepFrom[i] = static_cast<std::size_t>(spec - c.tokens.begin());
+            pos = synced ? c.stop : lexer.pos;
+        }
+
+        // Copying the survivors into place is as big a pass as the lexing, so it's
+        // done per chunk on the same threads
+        std::vector<std::size_t> at(chunks.size() + 1, 0);
+        for (std::size_t i = 0; i < chunks.size(); i++) at[i+1] = at[i] + relexed[i].size() + chunks[i].tokens.size() - keepFrom[i];
+        std::vector<Token> tokens(at.back());
+        auto place = [&](std::size_t i) {
+            auto out = std::copy(relexed[i].begin(), relexed[i].end(), tokens.begin() + at[i]);
+            std::copy(chunks[i].tokens.begin() + keepFrom[i], chunks[i].tokens.end(), out);
+        };
+        workers.clear();
+        for (std::size_t i = 1; i < chunks.size(); i++) workers.emplace_back(place, i);
+        place(0);
+        for (std::thread& w: workers) w.join();
+        return tokens;
+    }
+};
+
+inline std::vector<Token> lexParallel(std::string_view input, unsigned threads) {
+    return ParallelLexer(input, threads).run();
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "lexer.cpp"
+
+#ifndef PULL_LEXER_CPP
+#define PULL_LEXER_CPP
+
+// Lexes on demand: tokens are produced as the consumer asks for them and held in a
+// fixed ring of Lookahead slots, so memory doesn't grow with the input.
+//   peek(k) - the k-th token not yet consumed (k < Lookahead), lexing up to it
+//   next()  - consumes and returns the next token
+// Trivia is skipped; once the input runs out every call returns an End token.
+struct PullLexer {
+    static constexpr std::size_t Lookahead = 64;
+    static_assert((Lookahead & (Lookahead - 1)) == 0, "Lookahead must be a power of two");
+
+    Lexer lexer;
+    Token ring[Lookahead];
+    std::size_t head = 0;  // ring slot of the next unconsumed token
+    std::size_t count = 0; // tokens lexed but not yet consumed
+
+    explicit PullLexer(std::string_view input) : lexer{ input } {}
+
+    const Token& peek(std::size_t k) {
+        if (k >= Lookahead) throw std::out_of_range("peek(" + std::to_string(k) + ") is past the lookahead window");
+        while (count <= k) {
+            ring[(head + count) & (Lookahead - 1)] = lexer.next();
+            count++;
+        }
+        return ring[(head + k) & (Lookahead - 1)];
+    }
+
+    Token next() {
+        Token t = peek(0);
+        if (t.kind != TokenKind::End) {
+            head = (head + 1) & (Lookahead - 1);
+            count--;
+        }
+        return t;
+    }
+};
+
+// What the grammar reads tokens through. Rules address tokens by absolute index
+// (and report parse errors by it), so the cursor maps index i either into a
+// materialized token vector or onto a PullLexer. In the PullLexer case only the
+// last Lookahead tokens stay reachable: asking for i moves the window forward
+// and drops everything before i - Lookahead + 1. The grammar only looks a few
+// tokens back from the furthest one it has read, so this never trips in practice.
+struct TokenCursor {
+    std::vector<Token> tokens;
+    PullLexer* lexer = nullptr;
+    std::size_t consumed = 0; // index of the oldest token still in the lexer's window
+
+    TokenCursor() {}
+    TokenCursor(std::vector<Token> tokens) : tokens(std::move(tokens)) {}
+    TokenCursor(PullLexer& lexer) : lexer(&lexer) {}
+
+    const Token& operator[](std::size_t i) {
+        if (!lexer) return tokens[i];
+        if (i < consumed) throw std::logic_error("token " + std::to_string(i) + " has left the lookahead window");
+        while (i - consumed >= PullLexer::Lookahead) {
+            lexer->next();
+            consumed++;
+        }
+        return lexer->peek(i - consumed);
+    }
+
+    // Whether there is a token at index i, i.e. i is before the end of the input
+    bool has(std::size_t i) {
+        if (!lexer) return i < tokens.size();
+        return (*this)[i].kind != TokenKind::End;
+    }
+};
+
+#endif
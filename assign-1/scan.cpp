@@ -0,0 +1,165 @@
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+#ifndef SCAN_CPP
+#define SCAN_CPP
+
+// Run-skipping kernels for the lexer's long lexemes. Each returns the first index
+// j in [i, n) where the run ends (or n), with p[0, n) the input buffer:
+//   skipWhitespace - first byte that isn't ' ', '\t', '\n' or '\r'
+//   findNewline    - first '\n' (end of a // comment)
+//   findBlockEnd   - first j with p[j..j+1] == "*/" (end of a /* comment)
+//   skipAlnum      - first byte outside [A-Za-z0-9] (end of an identifier)
+// The SSE2 and AVX2 versions look at 16/32 bytes per step and finish the tail
+// with the scalar code; best() picks one at runtime from CPUID.
+namespace scan {
+
+using Kernel = std::size_t (*)(const char* p, std::size_t i, std::size_t n);
+
+struct Kernels {
+    const char* name;
+    Kernel skipWhitespace;
+    Kernel findNewline;
+    Kernel findBlockEnd;
+    Kernel skipAlnum;
+};
+
+inline bool isSpace(unsigned char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+inline bool isAlnum(unsigned char c) { return (unsigned char)(c - '0') < 10 || (unsigned char)((c | 0x20) - 'a') < 26; }
+
+inline std::size_t scalarSkipWhitespace(const char* p, std::size_t i, std::size_t n) {
+    while (i < n && isSpace(p[i])) i++;
+    return i;
+}
+inline std::size_t scalarFindNewline(const char* p, std::size_t i, std::size_t n) {
+    while (i < n && p[i] != '\n') i++;
+    return i;
+}
+inline std::size_t scalarFindBlockEnd(const char* p, std::size_t i, std::size_t n) {
+    while (i + 1 < n && !(p[i] == '*' && p[i+1] == '/')) i++;
+    return (i + 1 < n) ? i : n;
+}
+inline std::size_t scalarSkipAlnum(const char* p, std::size_t i, std::size_t n) {
+    while (i < n && isAlnum(p[i])) i++;
+    return i;
+}
+
+inline const Kernels scalarKernels = { "scalar", scalarSkipWhitespace, scalarFindNewline, scalarFindBlockEnd, scalarSkipAlnum };
+
+#ifdef SCAN_X86
+
+inline unsigned firstBit(uint32_t mask) { return static_cast<unsigned>(__builtin_ctz(mask)); }
+
+// SSE2 is part of the x86-64 baseline, so these need no target attribute.
+inline __m128i sse2Space(__m128i v) {
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    return _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+}
+// Unsigned range checks done as signed compares after biasing into [-128, ...)
+inline __m128i sse2Alnum(__m128i v) {
+    __m128i digit = _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - '0'))), _mm_set1_epi8((char)(0x80 + 10)));
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i alpha = _mm_cmplt_epi8(_mm_add_epi8(lower, _mm_set1_epi8((char)(0x80 - 'a'))), _mm_set1_epi8((char)(0x80 + 26)));
+    return _mm_or_si128(digit, alpha);
+}
+
+inline std::size_t sse2SkipWhitespace(const char* p, std::size_t i, std::size_t n) {
+    for (; i + 16 <= n; i += 16) {
+        uint32_t stop = ~_mm_movemask_epi8(sse2Space(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)))) & 0xFFFF;
+        if (stop) return i + firstBit(stop);
+    }
+    return scalarSkipWhitespace(p, i, n);
+}
+inline std::size_t sse2FindNewline(const char* p, std::size_t i, std::size_t n) {
+    for (; i + 16 <= n; i += 16) {
+        uint32_t hit = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), _mm_set1_epi8('\n')));
+        if (hit) return i + firstBit(hit);
+    }
+    return scalarFindNewline(p, i, n);
+}
+inline std::size_t sse2FindBlockEnd(const char* p, std::size_t i, std::size_t n) {
+    for (; i + 17 <= n; i += 16) {
+        __m128i star = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), _mm_set1_epi8('*'));
+        __m128i slash = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 1)), _mm_set1_epi8('/'));
+        uint32_t hit = _mm_movemask_epi8(_mm_and_si128(star, slash));
+        if (hit) return i + firstBit(hit);
+    }
+    return scalarFindBlockEnd(p, i, n);
+}
+inline std::size_t sse2SkipAlnum(const char* p, std::size_t i, std::size_t n) {
+    for (; i + 16 <= n; i += 16) {
+        uint32_t stop = ~_mm_movemask_epi8(sse2Alnum(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)))) & 0xFFFF;
+        if (stop) return i + firstBit(stop);
+    }
+    return scalarSkipAlnum(p, i, n);
+}
+
+inline const Kernels sse2Kernels = { "sse2", sse2SkipWhitespace, sse2FindNewline, sse2FindBlockEnd, sse2SkipAlnum };
+
+#define SCAN_AVX2 __attribute__((target("avx2")))
+
+SCAN_AVX2 inline __m256i avx2Space(__m256i v) {
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+    return _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+}
+SCAN_AVX2 inline __m256i avx2Alnum(__m256i v) {
+    __m256i digit = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + 10)), _mm256_add_epi8(v, _mm256_set1_epi8((char)(0x80 - '0'))));
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i alpha = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + 26)), _mm256_add_epi8(lower, _mm256_set1_epi8((char)(0x80 - 'a'))));
+    return _mm256_or_si256(digit, alpha);
+}
+
+SCAN_AVX2 inline std::size_t avx2SkipWhitespace(const char* p, std::size_t i, std::size_t n) {
+    for (; i + 32 <= n; i += 32) {
+        uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(avx2Space(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)))));
+        if (stop) return i + firstBit(stop);
+    }
+    return sse2SkipWhitespace(p, i, n);
+}
+SCAN_AVX2 inline std::size_t avx2FindNewline(const char* p, std::size_t i, std::size_t n) {
+    for (; i + 32 <= n; i += 32) {
+        uint32_t hit = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), _mm256_set1_epi8('\n')));
+        if (hit) return i + firstBit(hit);
+    }
+    return sse2FindNewline(p, i, n);
+}
+SCAN_AVX2 inline std::size_t avx2FindBlockEnd(const char* p, std::size_t i, std::size_t n) {
+    for (; i + 33 <= n; i += 32) {
+        __m256i star = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), _mm256_set1_epi8('*'));
+        __m256i slash = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 1)), _mm256_set1_epi8('/'));
+        uint32_t hit = _mm256_movemask_epi8(_mm256_and_si256(star, slash));
+        if (hit) return i + firstBit(hit);
+    }
+    return sse2FindBlockEnd(p, i, n);
+}
+SCAN_AVX2 inline std::size_t avx2SkipAlnum(const char* p, std::size_t i, std::size_t n) {
+    for (; i + 32 <= n; i += 32) {
+        uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(avx2Alnum(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)))));
+        if (stop) return i + firstBit(stop);
+    }
+    return sse2SkipAlnum(p, i, n);
+}
+
+inline const Kernels avx2Kernels = { "avx2", avx2SkipWhitespace, avx2FindNewline, avx2FindBlockEnd, avx2SkipAlnum };
+
+#undef SCAN_AVX2
+
+#endif
+
+// The widest kernels this CPU supports, decided once.
+inline const Kernels& best() {
+#ifdef SCAN_X86
+    static const Kernels& chosen = __builtin_cpu_supports("avx2") ? avx2Kernels : sse2Kernels;
+    return chosen;
+#else
+    return scalarKernels;
+#endif
+}
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef SOURCE_CPP
+#define SOURCE_CPP
+
+// Read-only contents of an input file, exposed as a string_view. Regular files are
+// mmapped so the lexer reads the page cache directly; pipes, ttys and stdin ("-")
+// fall back to read() into a single buffer. Throws std::runtime_error if the file
+// can't be opened or read.
+struct SourceFile {
+    const char* data = nullptr;
+    std::size_t size = 0;
+    bool mapped = false;
+    std::string buffer; // only used by the read() fallback
+
+    explicit SourceFile(const std::string& path) {
+        int fd = (path == "-") ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error(path + ": " + std::strerror(errno));
+        // Closes fd however the constructor ends, a throw from readAll included
+        struct Closer {
+            int fd;
+            ~Closer() { if (fd != STDIN_FILENO) close(fd); }
+        } closer{fd};
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            size = static_cast<std::size_t>(st.st_size);
+            if (size > 0) {
+                void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    madvise(p, size, MADV_SEQUENTIAL);
+                    data = static_cast<const char*>(p);
+                    mapped = true;
+                }
+            }
+        }
+        if (!mapped) readAll(fd, path);
+    }
+    ~SourceFile() {
+        if (mapped) munmap(const_cast<char*>(data), size);
+    }
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    std::string_view view() const { return std::string_view(data, size); }
+
+  private:
+    void readAll(int fd, const std::string& path) {
+        buffer.clear();
+        std::size_t used = 0;
+        buffer.resize(1 << 16);
+        while (true) {
+            if (used == buffer.size()) buffer.resize(buffer.size() * 2);
+            ssize_t got = read(fd, &buffer[used], buffer.size() - used);
+            if (got == 0) break;
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(path + ": " + std::strerror(errno));
+            }
+            used += static_cast<std::size_t>(got);
+        }
+        buffer.resize(used);
+        data = buffer.data();
+        size = buffer.size();
+    }
+};
+
+#endif
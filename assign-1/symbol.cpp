@@ -0,0 +1,90 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#ifndef SYMBOL_CPP
+#define SYMBOL_CPP
+
+// Identifiers are interned once, when the parser first sees them, and travel
+// through the compiler as 32-bit SymbolIds: AST names and every symbol table are
+// keyed by id, so comparing or hashing a name is an integer operation. The text
+// is only looked up again (str(), or printing the id) when something is output.
+// SymbolId is a struct rather than a bare integer so that an id can't end up in
+// a string concatenation or an output stream as a number.
+struct SymbolId {
+    uint32_t id = 0;
+
+    bool operator==(SymbolId other) const { return id == other.id; }
+    bool operator!=(SymbolId other) const { return id != other.id; }
+    bool operator<(SymbolId other) const { return id < other.id; } // by interning order, not by name
+    const std::string& str() const;
+};
+
+template<> struct std::hash<SymbolId> {
+    std::size_t operator()(SymbolId s) const noexcept { return s.id; }
+};
+
+// The process-wide interner; get it with symbols(). intern() may be called from
+// several threads. Names live in fixed-size chunks that never move, so name()
+// takes no lock and references to names stay valid forever.
+struct SymbolTable {
+    static constexpr std::size_t ChunkBits = 12;
+    static constexpr std::size_t ChunkSize = std::size_t(1) << ChunkBits;
+    static constexpr std::size_t MaxChunks = std::size_t(1) << 16;
+
+    // Pre-interned names the checker and lowering test for
+    static constexpr SymbolId Underscore{ 0 }; // "_", the name of Any
+    static constexpr SymbolId Main{ 1 };       // "main"
+    static constexpr SymbolId Int{ 2 };        // "int", the name Num reports
+
+    std::mutex mutex;
+    std::unordered_map<std::string_view, SymbolId> ids; // views into the chunks
+    std::atomic<std::string*> chunks[MaxChunks] = {};
+    uint32_t count = 0;
+
+    SymbolTable() {
+        intern("_");
+        intern("main");
+        intern("int");
+    }
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+    ~SymbolTable() {
+        for (auto& chunk: chunks) delete[] chunk.load();
+    }
+
+    SymbolId intern(std::string_view name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        std::size_t chunk = count >> ChunkBits;
+        if (chunk >= MaxChunks) throw std::length_error("too many distinct identifiers");
+        if (!chunks[chunk].load(std::memory_order_relaxed)) chunks[chunk].store(new std::string[ChunkSize], std::memory_order_release);
+        std::string& slot = chunks[chunk].load(std::memory_order_relaxed)[count & (ChunkSize - 1)];
+        slot = name;
+        SymbolId id{ count++ };
+        ids.emplace(slot, id);
+        return id;
+    }
+
+    const std::string& name(SymbolId s) const {
+        return chunks[s.id >> ChunkBits].load(std::memory_order_acquire)[s.id & (ChunkSize - 1)];
+    }
+};
+
+inline SymbolTable& symbols() {
+    static SymbolTable table;
+    return table;
+}
+
+inline const std::string& SymbolId::str() const { return symbols().name(*this); }
+
+inline std::ostream& operator<<(std::ostream& os, SymbolId s) { return os << s.str(); }
+
+#endif
@@ -0,0 +1,135 @@
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "lexer.cpp"
+
+#ifndef TOKEN_STREAM_CPP
+#define TOKEN_STREAM_CPP
+
+// Binary token stream passed from the lexer to the parser:
+//   header   "CFTK", u32 version, u32 token count, u32 string table size
+//   records  count x { u8 kind, u8 pad[3], u32 offset, u32 length }
+//   strings  the Id and Num lexemes, each distinct lexeme stored once
+// offset/length locate a record's lexeme in the string table and are 0 for
+// every other kind. The kind byte is the TokenKind value, so reordering
+// TokenKind means bumping the version.
+namespace token_stream {
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t stringBytes;
+};
+struct Record {
+    uint8_t kind;
+    uint8_t pad[3];
+    uint32_t offset;
+    uint32_t length;
+};
+static_assert(sizeof(Header) == 16 && sizeof(Record) == 12, "token stream layout");
+
+constexpr char magic[4] = { 'C', 'F', 'T', 'K' };
+constexpr uint32_t version = 1;
+
+inline bool isBinary(std::string_view data) {
+    return data.size() >= sizeof(Header) && std::memcmp(data.data(), magic, sizeof(magic)) == 0;
+}
+
+}
+
+struct TokenStreamWriter {
+    std::vector<token_stream::Record> records;
+    std::string strings;
+    std::unordered_map<std::string_view, uint32_t> offsets; // lexeme -> offset in strings
+
+    void add(const Token& t) {
+        token_stream::Record r = { static_cast<uint8_t>(t.kind), { 0, 0, 0 }, 0, 0 };
+        if (hasLexeme(t.kind)) {
+            auto [it, inserted] = offsets.try_emplace(t.text, static_cast<uint32_t>(strings.size()));
+            if (inserted) strings += t.text;
+            r.offset = it->second;
+            r.length = static_cast<uint32_t>(t.text.size());
+        }
+        records.push_back(r);
+    }
+
+    void write(std::ostream& out) const {
+        token_stream::Header h;
+        std::memcpy(h.magic, token_stream::magic, sizeof(h.magic));
+        h.version = token_stream::version;
+        h.count = static_cast<uint32_t>(records.size());
+        h.stringBytes = static_cast<uint32_t>(strings.size());
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(token_stream::Record));
+        out.write(strings.data(), strings.size());
+    }
+};
+
+// Decodes a binary token stream in place: lexemes are views into data, which
+// must outlive the tokens. Throws std::runtime_error if data is malformed.
+inline std::vector<Token> readBinaryTokens(std::string_view data) {
+    using namespace token_stream;
+    Header h;
+    std::memcpy(&h, data.data(), sizeof(h));
+    if (h.version != version) throw std::runtime_error("unsupported token stream version " + std::to_string(h.version));
+    const std::size_t recordBytes = std::size_t(h.count) * sizeof(Record);
+    if (data.size() < sizeof(Header) + recordBytes + h.stringBytes) throw std::runtime_error("truncated token stream");
+    const char* records = data.data() + sizeof(Header);
+    const std::string_view strings = data.substr(sizeof(Header) + recordBytes, h.stringBytes);
+    std::vector<Token> tokens(h.count);
+    for (uint32_t i = 0; i < h.count; i++) {
+        Record r;
+        std::memcpy(&r, records + std::size_t(i) * sizeof(Record), sizeof(r));
+        if (r.kind >= static_cast<uint8_t>(TokenKind::End) || std::size_t(r.offset) + r.length > strings.size()) {
+            throw std::runtime_error("bad token record " + std::to_string(i));
+        }
+        tokens[i] = Token{ static_cast<TokenKind>(r.kind), strings.substr(r.offset, r.length) };
+    }
+    return tokens;
+}
+
+// Decodes the text format, one token per line (`Id(foo)`, `Arrow`, ...). Lines that
+// don't name a token become Error tokens so token indices still match line numbers.
+inline std::vector<Token> readTextTokens(std::string_view data) {
+    static const std::unordered_map<std::string_view, TokenKind> kinds = [] {
+        std::unordered_map<std::string_view, TokenKind> m;
+        for (uint8_t k = 0; k <= static_cast<uint8_t>(TokenKind::Error); k++) m[tokenKindName(static_cast<TokenKind>(k))] = static_cast<TokenKind>(k);
+        return m;
+    }();
+    auto trim = [](std::string_view s) {
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+        return s;
+    };
+    std::vector<Token> tokens;
+    std::size_t i = 0;
+    while (i < data.size()) {
+        std::size_t end = data.find('\n', i);
+        if (end == std::string_view::npos) end = data.size();
+        std::string_view line = trim(data.substr(i, end - i));
+        i = end + 1;
+        std::string_view lexeme;
+        std::size_t paren = line.find('(');
+        if (paren != std::string_view::npos && line.back() == ')') {
+            lexeme = trim(line.substr(paren + 1, line.size() - paren - 2));
+            line = trim(line.substr(0, paren));
+        }
+        auto it = kinds.find(line);
+        if (it == kinds.end() || hasLexeme(it->second) != (paren != std::string_view::npos)) tokens.push_back(Token{ TokenKind::Error, line });
+        else tokens.push_back(Token{ it->second, lexeme });
+    }
+    return tokens;
+}
+
+inline std::vector<Token> readTokens(std::string_view data) {
+    return token_stream::isBinary(data) ? readBinaryTokens(data) : readTextTokens(data);
+}
+
+#endif
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef ARENA_CPP
+#define ARENA_CPP
+
+// Bump-pointer allocator for the AST. Nodes are carved out of 64 KB blocks and are
+// never freed one by one: the arena releases every block at once when it is
+// destroyed. Objects whose destructor does something (those holding a string or a
+// vector) get it run then, newest first; trivially destructible nodes cost nothing
+// to tear down. Pointers into the arena stay valid for the arena's lifetime.
+struct Arena {
+    static constexpr std::size_t BlockSize = 64 * 1024;
+
+    struct Finalizer {
+        void (*destroy)(void*);
+        void* object;
+    };
+
+    std::vector<char*> blocks;
+    char* next = nullptr;  // first free byte in the current block
+    char* limit = nullptr; // end of the current block
+    std::vector<Finalizer> finalizers;
+
+    Arena() {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() { release(); }
+
+    void* allocate(std::size_t size, std::size_t align) {
+        std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(next) + align - 1) & ~(align - 1);
+        if (!next || p + size > reinterpret_cast<std::uintptr_t>(limit)) {
+            // Oversized requests get a block of their own
+            std::size_t bytes = std::max(BlockSize, size + align);
+            char* block = static_cast<char*>(::operator new(bytes));
+            blocks.push_back(block);
+            next = block;
+            limit = block + bytes;
+            p = (reinterpret_cast<std::uintptr_t>(next) + align - 1) & ~(align - 1);
+        }
+        next = reinterpret_cast<char*>(p + size);
+        return reinterpret_cast<void*>(p);
+    }
+
+    template<class T, class... Args>
+    T* make(Args&&... args) {
+        T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            finalizers.push_back(Finalizer{ [](void* p) { static_cast<T*>(p)->~T(); }, object });
+        }
+        return object;
+    }
+
+    void release() {
+        for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it) it->destroy(it->object);
+        finalizers.clear();
+        for (char* block: blocks) ::operator delete(block);
+        blocks.clear();
+        next = limit = nullptr;
+    }
+};
+
+#endif
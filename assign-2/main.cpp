@@ -1,27 +1,24 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <map>
 #include <algorithm>
+#include "../assign-1/source.cpp"
+#include "../assign-1/token_stream.cpp"
 #include "grammar.cpp"
 
-using Gamma = std::unordered_map<std::string, TypeName*>;
+using Gamma = Scope<std::string, TypeName*>;
 using Delta = std::unordered_map<std::string, Gamma>;
 
 Gamma globals_map;
 Delta delta;
-std::unordered_map<std::string, Gamma> locals_map;
+std::unordered_map<std::string, Gamma> locals_map; // chained to globals_map
 std::unordered_map<std::string, ParamsReturnVal> functions_map;
 std::unordered_map<std::string, FunctionsInfo> struct_functions_map;
 std::vector<std::string> errors_map;
 
-const bool isWhitespace(unsigned char c) {
-    return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f');
-}
-
 void initializeMaps(AST::Program* prog) {
     for (AST::Decl* g: prog->globals) { 
         globals_map[g->name] = new TypeName(g->typeName());
@@ -47,10 +44,7 @@ void initializeMaps(AST::Program* prog) {
         functions_map[f->name] = f->funcInfo();
     }
     for (AST::Function* f: prog->functions) { // Creating locals map
-        Gamma temp_map;
-        for (const auto& [name, type_name_pointer] : globals_map) {
-            temp_map.insert(std::make_pair(std::move(name), new TypeName(*type_name_pointer))); // Inserts all globals into function
-        }
+        Gamma temp_map(&globals_map); // globals are looked up through the chain, not copied
         for (AST::Decl* p: f->params) { 
             temp_map[p->name] = new TypeName(p->typeName()); 
             if (p->typeName().isPointerToFunction()) { functions_map[p->name] = p->funcInfo(); } 
@@ -68,26 +62,23 @@ int main(int argc, char** argv) {
         std::cerr << "No argument provided\n"; 
         return 1; 
     }
-    std::string input;
+    std::unique_ptr<SourceFile> source;
     try {
-        std::ifstream ifs(argv[1]);
-        std::stringstream buffer;
-        buffer << ifs.rdbuf();
-        input = buffer.str();
+        source = std::make_unique<SourceFile>(argv[1]);
     }
     catch(const std::exception& e) {
         std::cerr << "Invalid file\n";
         return 1;
     }
-    std::stringstream ss(input);
-    std::string s;
-    std::vector<std::string> tokens;
-    while (std::getline(ss, s, '\n')) { 
-        s.erase(std::remove_if(s.begin(), s.end(), isWhitespace), s.end());
-        tokens.push_back(s);
-    }
+    // Accepts both the binary token stream (lex --binary) and the one-token-per-line text format
     Grammar g;
-    g.tokens = tokens;
+    try {
+        g.tokens = readTokens(source->view());
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Invalid token stream: " << e.what() << "\n";
+        return 1;
+    }
     AST::Program* prog;
     try {
         prog = g.program(0);
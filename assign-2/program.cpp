@@ -1,3 +1,5 @@
+#include <cassert>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <optional>
@@ -6,6 +8,9 @@
 #include <map>
 #include <variant>
 #include <tuple>
+#include <type_traits>
+#include "arena.cpp"
+#include "scope.cpp"
 
 struct TypeName {
     std::string type_name;
@@ -42,24 +47,70 @@ struct Type;
 struct Function;
 
 using ParamsReturnVal = std::pair<std::vector<Type*>, Type*>;
-using Gamma = std::unordered_map<std::string, TypeName*>;
+using Gamma = Scope<std::string, TypeName*>; // a function's names over the globals, see Scope
 using Delta = std::unordered_map<std::string, Gamma>;
 using Errors = std::vector<std::string>;
 using FunctionsInfo = std::unordered_map<std::string, ParamsReturnVal>;
 using StructFunctionsInfo = std::unordered_map<std::string, FunctionsInfo>;
 
+// Nodes without state (the operators and the `int` and `_` types) are never
+// allocated per use: every occurrence points at this one shared instance
+template<class T>
+T* singleton() {
+    static T instance;
+    return &instance;
+}
+
+// Every Type, Exp, Lval, Rhs and Stmt node records its concrete class in `kind`,
+// set by its constructor, and each class has a classof() telling whether a node
+// is one of it. Node tests are then a compare on the tag rather than RTTI:
+//   isa<T>(n)      - whether n is a T
+//   cast<T>(n)     - n as a T; it must be one
+//   dyn_cast<T>(n) - n as a T, or nullptr if it is something else
+enum class Kind : uint8_t {
+    // Type
+    Int, StructType, Fn, Ptr, Any,
+    // Exp
+    Num, ExpId, Nil, UnOp, BinOp, ExpArrayAccess, ExpFieldAccess, ExpCall, AnyExp,
+    // Lval
+    LvalId, LvalDeref, LvalArrayAccess, LvalFieldAccess,
+    // Rhs
+    RhsExp, New,
+    // Stmt
+    Break, Continue, Return, Assign, StmtCall, If, While,
+};
+
+template<class To, class From>
+using CastResult = std::conditional_t<std::is_const_v<From>, const To*, To*>;
+
+template<class To, class From>
+bool isa(const From* node) { return To::classof(node); }
+
+template<class To, class From>
+CastResult<To, From> cast(From* node) {
+    assert(isa<To>(node));
+    return static_cast<CastResult<To, From>>(node);
+}
+
+template<class To, class From>
+CastResult<To, From> dyn_cast(From* node) {
+    return isa<To>(node) ? static_cast<CastResult<To, From>>(node) : nullptr;
+}
+
 struct Type {
+    const Kind kind;
+    explicit Type(Kind kind) : kind(kind) {}
     virtual void print(std::ostream& os) const {}
-    virtual bool isAny() const { return false; }
     virtual TypeName typeName() const { return TypeName("_"); }
     virtual ParamsReturnVal funcInfo() const;
-    virtual ~Type() {}
     friend std::ostream& operator<<(std::ostream& os, const Type& obj) {
         obj.print(os);
         return os;
     }
 };
 struct Int : Type {
+    Int() : Type(Kind::Int) {}
+    static bool classof(const Type* n) { return n->kind == Kind::Int; }
     void print(std::ostream& os) const override {
         os << "Int";
     }
@@ -69,6 +120,8 @@ struct Int : Type {
 };
 struct StructType : Type {
     std::string name;
+    StructType() : Type(Kind::StructType) {}
+    static bool classof(const Type* n) { return n->kind == Kind::StructType; }
     void print(std::ostream& os) const override { 
         os << "Struct(" << name << ")"; 
     }
@@ -80,6 +133,8 @@ struct Fn : Type {
     std::vector<Type*> prms;
     // WARNING: if there is no return for Fn, ret is Any (look at struct Any : Type)
     Type* ret;
+    Fn() : Type(Kind::Fn) {}
+    static bool classof(const Type* n) { return n->kind == Kind::Fn; }
     void print(std::ostream& os) const override { 
         os << "Fn(prms = [";
         for (unsigned int i = 0; i < prms.size(); i++) {
@@ -98,13 +153,11 @@ struct Fn : Type {
         return TypeName(temp);
     }
     ParamsReturnVal funcInfo () const override { return std::make_pair(prms, ret); }
-    ~Fn() {
-        for (Type* t: prms) delete t;
-        delete ret;
-    }
 };
 struct Ptr : Type {
     Type* ref;
+    Ptr() : Type(Kind::Ptr) {}
+    static bool classof(const Type* n) { return n->kind == Kind::Ptr; }
     void print(std::ostream& os) const override { 
         os << "Ptr(" << *ref << ")";
     }
@@ -113,8 +166,8 @@ struct Ptr : Type {
         const Type* temp = ref;
         while (temp) {
             ptr_type_names += "&";
-            if (dynamic_cast<const Ptr*>(temp)) { // Checks if temp is a pointer type
-                temp = static_cast<const Ptr*>(temp)->ref;
+            if (const Ptr* ptr = dyn_cast<Ptr>(temp)) {
+                temp = ptr->ref;
             } else {
                 ptr_type_names += temp->typeName().type_name;
                 break;
@@ -123,16 +176,16 @@ struct Ptr : Type {
         return TypeName(ptr_type_names);
     }
     ParamsReturnVal funcInfo () const override { return ref->funcInfo(); }
-    ~Ptr() { delete ref; }
 };
 struct Any : Type {
+    Any() : Type(Kind::Any) {}
+    static bool classof(const Type* n) { return n->kind == Kind::Any; }
     void print(std::ostream& os) const override { 
         os << "_";
     }
     TypeName typeName() const override {
         return TypeName("_");
     }
-    bool isAny() const override { return true; }
 };
 
 struct UnaryOp {
@@ -193,12 +246,11 @@ struct Gte : BinaryOp{
 };
 
 struct Exp {
+    const Kind kind;
+    explicit Exp(Kind kind) : kind(kind) {}
     virtual void print(std::ostream& os) const {}
     virtual TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const { return TypeName("_"); };
     virtual std::string getName() { return "_"; };
-    virtual bool isAny() const { return false; }
-    virtual bool isFieldAccess() const { return false; }
-    virtual ~Exp() {}
     friend std::ostream& operator<<(std::ostream& os, const Exp& exp) {
         exp.print(os);
         return os;
@@ -206,38 +258,46 @@ struct Exp {
 };
 struct Num : Exp {
     int32_t n;
+    Num() : Exp(Kind::Num) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::Num; }
     void print(std::ostream& os) const override { os << "Num(" << n << ")"; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override { return TypeName("int"); };
     std::string getName() override { return "int"; }
 };
 struct ExpId : Exp {
     std::string name;
-    ExpId() {}
-    ExpId(const std::string& name) : name(name) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::ExpId; }
+    ExpId() : Exp(Kind::ExpId) {}
+    ExpId(const std::string& name) : Exp(Kind::ExpId), name(name) {}
     void print(std::ostream& os) const override { os << "Id(" << name << ")"; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
     std::string getName() override { return name; }
 };
 struct Nil : Exp {
+    Nil() : Exp(Kind::Nil) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::Nil; }
     void print(std::ostream& os) const override { os << "Nil"; }
     TypeName typeName() const { return TypeName("&_"); }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override { return TypeName("&_");};
     std::string getName() override { return "_"; }
 };
 struct UnOp : Exp {
-    UnaryOp* op;
+    const UnaryOp* op; // shared, see singleton()
     Exp* operand;
+    UnOp() : Exp(Kind::UnOp) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::UnOp; }
     void print(std::ostream& os) const override { os << *op << "(" << *operand << ")"; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override {
         return op->typeCheck(gamma, fun, errors, operand);
     }
     std::string getName() override { return operand->getName(); }
-    ~UnOp() { delete operand; }
 };
 struct BinOp : Exp {
-    BinaryOp* op;
+    const BinaryOp* op; // shared, see singleton()
     Exp* left;
     Exp* right;
+    BinOp() : Exp(Kind::BinOp) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::BinOp; }
     void print(std::ostream& os) const override {
         os << "BinOp(\nop = " << *op << ",\nleft = " << *left << ",\nright = " << *right << "\n)"; 
     }
@@ -245,32 +305,34 @@ struct BinOp : Exp {
         return op->typeCheck(gamma, fun, errors, left, right);
     }
     std::string getName() override { return "_"; }
-    ~BinOp() { delete left; delete right; }
 };
 struct ExpArrayAccess : Exp {
     Exp* ptr;
     Exp* index;
+    ExpArrayAccess() : Exp(Kind::ExpArrayAccess) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::ExpArrayAccess; }
     void print(std::ostream& os) const override {
         os << "ArrayAccess(\nptr = " << *ptr << ",\nindex = " << *index << "\n)";
     }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
     std::string getName() override { return ptr->getName(); }
-    ~ExpArrayAccess() { delete ptr; delete index; }
 };
 struct ExpFieldAccess : Exp {
     Exp* ptr;
     std::string field;
+    ExpFieldAccess() : Exp(Kind::ExpFieldAccess) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::ExpFieldAccess; }
     void print(std::ostream& os) const override {
         os << "FieldAccess(\nptr = " << *ptr << ",\nfield = " << field << "\n)";
     }
-    bool isFieldAccess() const override { return true; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
     std::string getName() override { return field; }
-    ~ExpFieldAccess() { delete ptr; }
 };
 struct ExpCall : Exp {
     Exp* callee;
     std::vector<Exp*> args;
+    ExpCall() : Exp(Kind::ExpCall) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::ExpCall; }
     void print(std::ostream& os) const override {
         os << "Call(\ncallee = " << *callee << ",\nargs = [";
         for (unsigned int i = 0; i < args.size(); i++) {
@@ -280,25 +342,22 @@ struct ExpCall : Exp {
         os << "\n]\n)";
     }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    ~ExpCall() {
-        delete callee;
-        for (Exp* exp: args) delete exp;
-    }
     std::string getName() override { return callee->getName(); }
 };
 struct AnyExp : Exp {
+    AnyExp() : Exp(Kind::AnyExp) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::AnyExp; }
     void print(std::ostream& os) const override { os << "_"; }
     TypeName typeName() const { return TypeName("_"); }
-    bool isAny() const override { return true; }
     std::string getName() override { return "_"; }
 };
 
 struct Lval {
+    const Kind kind;
+    explicit Lval(Kind kind) : kind(kind) {}
     virtual void print(std::ostream& os) const {}
     virtual TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const { return TypeName("_"); };
     virtual std::string getName() { return "_"; }
-    virtual bool isFieldAccess() const { return false; }
-    virtual ~Lval() {}
     friend std::ostream& operator<<(std::ostream& os, const Lval& lval) {
         lval.print(os);
         return os;
@@ -306,44 +365,49 @@ struct Lval {
 };
 struct LvalId : Lval {
     std::string name;
+    LvalId() : Lval(Kind::LvalId) {}
+    static bool classof(const Lval* n) { return n->kind == Kind::LvalId; }
     void print(std::ostream& os) const override { os << "Id(" << name << ")"; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
     std::string getName() override { return name; }
 };
 struct LvalDeref : Lval {
     Lval* lval;
+    LvalDeref() : Lval(Kind::LvalDeref) {}
+    static bool classof(const Lval* n) { return n->kind == Kind::LvalDeref; }
     void print(std::ostream& os) const override { os << "Deref(" << *lval << ")"; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
     std::string getName() override { return lval->getName(); }
-    ~LvalDeref() { delete lval; }
 };
 struct LvalArrayAccess : Lval {
     Lval* ptr;
     Exp* index;
+    LvalArrayAccess() : Lval(Kind::LvalArrayAccess) {}
+    static bool classof(const Lval* n) { return n->kind == Kind::LvalArrayAccess; }
     void print(std::ostream& os) const override {
         os << "ArrayAccess(\nptr = " << *ptr << ",\nindex = " << *index << "\n)";
     }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
     std::string getName() override { return ptr->getName(); }
-    ~LvalArrayAccess() { delete ptr; delete index; }
 };
 struct LvalFieldAccess : Lval {
     Lval* ptr;
     std::string field;
+    LvalFieldAccess() : Lval(Kind::LvalFieldAccess) {}
+    static bool classof(const Lval* n) { return n->kind == Kind::LvalFieldAccess; }
     void print(std::ostream& os) const override {
         os << "FieldAccess(\nptr = " << *ptr << ",\nfield = " << field << "\n)";
     }
     std::string getName() override { return ptr->getName(); }
-    bool isFieldAccess() const override { return false;  }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    ~LvalFieldAccess() { delete ptr; }
 };
 
 
 struct Rhs {
+    const Kind kind;
+    explicit Rhs(Kind kind) : kind(kind) {}
     virtual void print(std::ostream& os) const {}
     virtual TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const { return TypeName("_"); };
-    virtual ~Rhs() {}
     friend std::ostream& operator<<(std::ostream& os, const Rhs& rhs) {
         rhs.print(os);
         return os;
@@ -351,57 +415,68 @@ struct Rhs {
 };
 struct RhsExp : Rhs {
     Exp* exp;
+    RhsExp() : Rhs(Kind::RhsExp) {}
+    static bool classof(const Rhs* n) { return n->kind == Kind::RhsExp; }
     void print(std::ostream& os) const override { os << *exp; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    ~RhsExp() { delete exp; }
 };
 struct New : Rhs {
     Type* type;
     Exp* amount;
+    New() : Rhs(Kind::New) {}
+    static bool classof(const Rhs* n) { return n->kind == Kind::New; }
     void print(std::ostream& os) const override { os << "New(" << *type << ", " << *amount << ")"; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    ~New() { delete type; delete amount; }
 };
 
 struct Stmt {
+    const Kind kind;
+    explicit Stmt(Kind kind) : kind(kind) {}
     virtual void print(std::ostream& os) const {}
     virtual bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const { return true; };
     virtual std::string getName() { return "_"; }
-    virtual ~Stmt() {}
     friend std::ostream& operator<<(std::ostream& os, const Stmt& stmt) {
         stmt.print(os);
         return os;
     }
 };
 struct Break : Stmt {
+    Break() : Stmt(Kind::Break) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::Break; }
     void print(std::ostream& os) const override { os << "Break"; }
     virtual bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
 };
 struct Continue : Stmt {
+    Continue() : Stmt(Kind::Continue) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::Continue; }
     void print(std::ostream& os) const override { os << "Continue"; }
     virtual bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
 };
 struct Return : Stmt {
     // WARNING: if there is no return, exp is AnyExp : Exp
     Exp* exp;
+    Return() : Stmt(Kind::Return) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::Return; }
     void print(std::ostream& os) const override {
         os << "Return(" << *exp << ")";
     }
     bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    ~Return() { delete exp; }
 };
 struct Assign : Stmt {
     Lval* lhs;
     Rhs* rhs;
+    Assign() : Stmt(Kind::Assign) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::Assign; }
     void print(std::ostream& os) const override {
         os << "Assign(\nlhs = " << *lhs << ",\nrhs = " << *rhs << "\n)";
     }
     bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    ~Assign() { delete lhs; delete rhs; }
 };
 struct StmtCall : Stmt {
     Lval* callee;
     std::vector<Exp*> args;
+    StmtCall() : Stmt(Kind::StmtCall) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::StmtCall; }
     void print(std::ostream& os) const override {
         os << "Call(\ncallee = " << *callee << ",\nargs = [";
         for (unsigned int i = 0; i < args.size(); i++) {
@@ -412,12 +487,13 @@ struct StmtCall : Stmt {
     }
     std::string getName() override { return callee->getName(); }
     bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    ~StmtCall() { delete callee; for (Exp* exp: args) delete exp; }
 };
 struct If : Stmt {
     Exp* guard;
     std::vector<Stmt*> tt;
     std::vector<Stmt*> ff;
+    If() : Stmt(Kind::If) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::If; }
     void print(std::ostream& os) const override {
         os << "If(\nguard = " << *guard << ",\ntt = [";
         for (unsigned int i = 0; i < tt.size(); i++) {
@@ -432,11 +508,12 @@ struct If : Stmt {
         os << "]\n)";
     }
     bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    ~If() { delete guard; for (Stmt* stmt: tt) delete stmt; for (Stmt* stmt: ff) delete stmt; }
 };
 struct While : Stmt {
     Exp* guard;
     std::vector<Stmt*> body;
+    While() : Stmt(Kind::While) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::While; }
     void print(std::ostream& os) const override {
         os << "While(\nguard = " << *guard << ",\nbody = [";
         for (unsigned int i = 0; i < body.size(); i++) {
@@ -446,7 +523,6 @@ struct While : Stmt {
         os << "]\n)";
     }
     bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    ~While() { delete guard; for (Stmt* stmt: body) delete stmt; }
 };
 
 struct Decl {
@@ -454,7 +530,6 @@ struct Decl {
     std::string name;
     Type* type; // Fn type if this Decl is an extern
     std::vector<Decl*> params; // optional, used to keep track of parameters for extern decl
-    ~Decl() { delete type; }
     friend std::ostream& operator<<(std::ostream& os, const Decl& decl) {
         os << "Decl(" << decl.name << ", " << *(decl.type) << ")";
         return os;
@@ -466,7 +541,6 @@ struct Decl {
 struct Struct {
     std::string name;
     std::vector<Decl*> fields;
-    ~Struct() { for (Decl* decl: fields) delete decl; }
     friend std::ostream& operator<<(std::ostream& os, const Struct& str) {
         os << "Struct(\nname = " << str.name << ",\nfields = [";
         for (unsigned int i = 0; i < str.fields.size(); i++) {
@@ -488,12 +562,6 @@ struct Function {
     // WARNING: for each local, if there is no value after declaration, Exp is AnyExp : Exp
     std::vector<std::pair<Decl*, Exp*>> locals;
     std::vector<Stmt*> stmts;
-    ~Function() {
-        for (Decl* decl: params) delete decl;
-        delete rettyp;
-        for (auto [decl, exp]: locals) { delete decl; delete exp; }
-        for (Stmt* stmt: stmts) delete stmt;
-    }
     friend std::ostream& operator<<(std::ostream& os, const Function& func) {
         os << "Function(\nname = " << func.name << ",\nparams = [";
         for (unsigned int i = 0; i < func.params.size(); i++) {
@@ -536,12 +604,9 @@ struct Program {
     std::vector<Struct*> structs;
     std::vector<Decl*> externs;
     std::vector<Function*> functions;
-    ~Program() { 
-        for (Decl* decl: globals) delete decl;
-        for (Struct* str: structs) delete str;
-        for (Decl* decl: externs) delete decl;
-        for (Function* function: functions) delete function;
-    }
+    // Owns every node of the tree but the shared singletons; they are all freed
+    // together with the Program
+    Arena arena;
     friend std::ostream& operator<<(std::ostream& os, const Program& prog) {
         os << "Program(\nglobals = [";
         for (unsigned int i = 0; i < prog.globals.size(); i++) {
@@ -573,7 +638,7 @@ struct Program {
 
 using namespace AST;
 using ParamsReturnVal = std::pair<std::vector<Type*>, Type*>;
-using Gamma = std::unordered_map<std::string, TypeName*>;
+using Gamma = Scope<std::string, TypeName*>; // a function's names over the globals, see Scope
 using Delta = std::unordered_map<std::string, Gamma>;
 using Errors = std::vector<std::string>;
 using FunctionsInfo = std::unordered_map<std::string, ParamsReturnVal>;
@@ -585,7 +650,7 @@ extern StructFunctionsInfo struct_functions_map;
 
 // General functions (with _TC for ones used by both Exp and Stmt) which depend on earlier definitions
 ParamsReturnVal Type::funcInfo () const {
-    return std::make_pair(std::vector<Type*>(), new Any());
+    return std::make_pair(std::vector<Type*>(), singleton<Any>());
 }
 
 TypeName RhsExp::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
@@ -593,13 +658,9 @@ TypeName RhsExp::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) co
 }
 
 TypeName const id_TC(Gamma& gamma, const Function* fun, Errors& errors, std::string name) {
-    try {
-        TypeName* temp = gamma.at(name); //Returns TypeName* struct
-        return *temp;
-    } catch (const std::out_of_range& e) {
-        errors.push_back("[ID] in function " + fun->name + ": variable " + name + " undefined");
-        return TypeName("_");
-    }
+    if (TypeName* const* temp = gamma.find(name)) return **temp;
+    errors.push_back("[ID] in function " + fun->name + ": variable " + name + " undefined");
+    return TypeName("_");
 }
 TypeName ExpId::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
     return id_TC(gamma, fun, errors, name);
@@ -692,7 +753,7 @@ TypeName const fieldAccess_TC(Gamma& gamma, const Function* fun, Errors& errors,
         errors.push_back("[FIELD] in function " + fun->name + ": accessing field of non-existent struct type " + struct_type);
         return TypeName("_");
     }
-    if (delta[struct_type].find(field) == delta[struct_type].end()) {
+    if (!delta[struct_type].find(field)) {
         errors.push_back("[FIELD] in function " + fun->name + ": accessing non-existent field " + field + " of struct type " + struct_type);
         return TypeName("_");
     }
@@ -709,7 +770,9 @@ TypeName LvalFieldAccess::typeCheck(Gamma& gamma, const Function* fun, Errors& e
 
 std::pair<TypeName, bool> call_TC(Gamma& gamma, const Function* fun, Errors& errors, std::variant<Exp*, Lval*> callee, std::vector<Exp*> arg) {    
     TypeName callee_type = std::visit([&callee_type, &gamma, &fun, &errors](auto* arg) { return arg->typeCheck(gamma, fun, errors); }, callee);
-    bool isFieldAccess = std::visit([](auto* arg) { return arg->isFieldAccess(); }, callee);
+    // Only expression calls go through the struct's field types: a statement call
+    // through a field is checked like one through a name
+    bool isFieldAccess = std::holds_alternative<Exp*>(callee) && isa<ExpFieldAccess>(std::get<Exp*>(callee));
     std::string callee_name = std::visit([](auto* arg) { return arg->getName(); }, callee); //field name for field, function for others
     
     if (callee_name == "_") { return std::pair<TypeName, bool>(TypeName("_"), true); } //no need to continue if Any
@@ -774,8 +837,8 @@ bool StmtCall::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& e
 }
 
 bool Return::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const {
-    bool is_return_type_any = fun->rettyp->isAny();
-    bool is_return_exp_any = exp->isAny();
+    bool is_return_type_any = isa<Any>(fun->rettyp);
+    bool is_return_exp_any = isa<AnyExp>(exp);
     TypeName return_type = fun->rettyp->typeName();
     TypeName exp_type = exp->typeCheck(gamma, fun, errors); //store typename given, typeCheck will replace undefined variables with Any
     if ( !is_return_exp_any && exp_type.type_name == "_") { 
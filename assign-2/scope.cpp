@@ -0,0 +1,38 @@
+#include <stdexcept>
+#include <unordered_map>
+
+#ifndef SCOPE_CPP
+#define SCOPE_CPP
+
+// One layer of a chain of name tables. A lookup tries this layer, then each
+// enclosing one, so inner bindings shadow outer ones. A function's scope holds
+// only its parameters and locals and points at the program's globals, which
+// are then shared by every function rather than copied into each. The enclosing
+// scope must outlive the ones chained to it.
+template<class Key, class Value>
+struct Scope {
+    std::unordered_map<Key, Value> names;
+    const Scope* parent = nullptr;
+
+    Scope() {}
+    explicit Scope(const Scope* parent) : parent(parent) {}
+
+    // The innermost binding of key, or nullptr if there is none
+    const Value* find(const Key& key) const {
+        for (const Scope* s = this; s; s = s->parent) {
+            auto it = s->names.find(key);
+            if (it != s->names.end()) return &it->second;
+        }
+        return nullptr;
+    }
+    const Value& at(const Key& key) const {
+        const Value* value = find(key);
+        if (!value) throw std::out_of_range("Scope::at");
+        return *value;
+    }
+    // Binds (or rebinds) key in this layer
+    Value& operator[](const Key& key) { return names[key]; }
+    void clear() { names.clear(); }
+};
+
+#endif
@@ -1,42 +1,53 @@
+#include <cassert>
+#include <cstdint>
 #include <string>
 #include <vector>
+#include <iterator>
 #include <optional>
 #include <iostream>
 #include <unordered_map>
+#include <unordered_set>
 #include <map>
 #include <variant>
 #include <tuple>
+#include <type_traits>
+#include "../assign-1/symbol.cpp"
+#include "types.cpp"
+#include "../assign-2/arena.cpp"
+#include "../assign-2/scope.cpp"
+#include "work_pool.cpp"
+#include "instructions.cpp"
 using namespace std;
 
 #ifndef AST_CPP
 #define AST_CPP
 
+// What checking an expression yields: its canonical type, and for a field access
+// the struct and field it read, which a call through the field needs
 struct TypeName {
-    string type_name;
-    string struct_name; // used to pass in for exp or *
-    string field_name;  // used to pass in for exp or *
-    TypeName( string t, string s = "", string f = "") : type_name(t), struct_name(s), field_name(f) {};
-    TypeName(const TypeName& other) : type_name(other.type_name) {}
-    TypeName& operator=(const TypeName& other) {
-        if (this != &other) type_name = other.type_name;
-        return *this;
-    }
+    const CanonType* type;
+    SymbolId struct_name; // used to pass in for exp or *
+    SymbolId field_name;  // used to pass in for exp or *
+    TypeName(const CanonType* t, SymbolId s = SymbolTable::Underscore, SymbolId f = SymbolTable::Underscore) : type(t), struct_name(s), field_name(f) {};
+    const string& str() const { return type->text; }
+    // _ matches anything, and nil (&_) any pointer
     bool operator==(const TypeName& other) const {
-        try {
-            if (type_name == "_" || other.type_name == "_") return true;
-            if (type_name == other.type_name) return true;
-            return type_name.at(0) == '&' && other.type_name.at(0) == '&' && (type_name.at(1) == '_' || other.type_name.at(1) == '_');
-        } catch (const out_of_range& e) {} 
-        return false;
+        if (type->isAny() || other.type->isAny()) return true;
+        if (type == other.type) return true;
+        return type->isPtr() && other.type->isPtr() && (type->isNil() || other.type->isNil());
     }
     bool operator!=(const TypeName& other) const {
         return !(*this == other);
     }
-    bool isFunction() const { return type_name[0] == '(' || type_name.substr(0,2) == "&("; }
-    bool isNonPointerFunction() const { return type_name[0] == '('; }
-    bool isStruct() const { return type_name[0] != '&' && type_name.find('(') == string::npos && type_name.substr(0,3) != "int"; }
-    bool isValidFieldAcesss() const { return type_name[0] == '&' && type_name[1] != '(' && type_name[1] != '&' && type_name.substr(0,5) != "&int"; }
-    bool isPointerToFunction() const { return type_name[0] == '(' || type_name.find("&(") != string::npos; }
+    bool isFunction() const { return type->isFn() || (type->isPtr() && type->ref->isFn()); }
+    bool isNonPointerFunction() const { return type->isFn(); }
+    bool isStruct() const { return type->isStruct(); }
+    bool isValidFieldAcesss() const { return type->isPtr() && (type->ref->isStruct() || type->ref->isAny()); }
+    bool isPointerToFunction() const {
+        const CanonType* t = type;
+        while (t->isPtr()) t = t->ref;
+        return t->isFn();
+    }
 };
 
 namespace AST {
@@ -47,47 +58,98 @@ struct Function;
 struct Lval;
 
 using ParamsReturnVal = pair<vector<Type*>, Type*>;
-using Gamma = unordered_map<string, Type*>;
-using Delta = unordered_map<string, Gamma>;
+using Gamma = Scope<SymbolId, Type*>; // a function's names over the globals, see Scope
+using Delta = unordered_map<SymbolId, Gamma>;
 using Errors = vector<string>;
-using FunctionsInfo = unordered_map<string, ParamsReturnVal>;
-using StructFunctionsInfo = unordered_map<string, FunctionsInfo>;
+using FunctionsInfo = unordered_map<SymbolId, ParamsReturnVal>;
+using StructFunctionsInfo = unordered_map<SymbolId, FunctionsInfo>;
+
+// Nodes without state (the operators and the `int` and `_` types) are never
+// allocated per use: every occurrence points at this one shared instance
+template<class T>
+T* singleton() {
+    static T instance;
+    return &instance;
+}
+
+// Every Type, Exp, Lval, Rhs and Stmt node records its concrete class in `kind`,
+// set by its constructor, and each class has a classof() telling whether a node
+// is one of it. Node tests are then a compare on the tag rather than RTTI:
+//   isa<T>(n)      - whether n is a T
+//   cast<T>(n)     - n as a T; it must be one
+//   dyn_cast<T>(n) - n as a T, or nullptr if it is something else
+enum class Kind : uint8_t {
+    // Type
+    Int, StructType, Fn, Ptr, Any,
+    // Exp
+    Num, ExpId, Nil, UnOp, BinOp, ExpArrayAccess, ExpFieldAccess, ExpCall, AnyExp,
+    // Lval
+    LvalId, LvalDeref, LvalArrayAccess, LvalFieldAccess,
+    // Rhs
+    RhsExp, New,
+    // Stmt
+    Break, Continue, Return, Assign, StmtCall, If, While,
+    // UnaryOp
+    Neg, UnaryDeref,
+    // BinaryOp
+    Add, Sub, Mul, Div, Equal, NotEq, Lt, Lte, Gt, Gte,
+};
+
+template<class To, class From>
+using CastResult = conditional_t<is_const_v<From>, const To*, To*>;
+
+template<class To, class From>
+bool isa(const From* node) { return To::classof(node); }
+
+template<class To, class From>
+CastResult<To, From> cast(From* node) {
+    assert(isa<To>(node));
+    return static_cast<CastResult<To, From>>(node);
+}
+
+template<class To, class From>
+CastResult<To, From> dyn_cast(From* node) {
+    return isa<To>(node) ? static_cast<CastResult<To, From>>(node) : nullptr;
+}
 
 struct Type {
+    const Kind kind;
+    // The canonical type this node spells out, set by canonicalize() once the
+    // node and its children are complete
+    const CanonType* canon = nullptr;
+    explicit Type(Kind kind) : kind(kind) {}
     virtual void print(ostream& os) const {}
-    virtual bool isAny() const { return false; }
-    virtual TypeName typeName() const { return TypeName("_"); }
+    virtual const CanonType* canonicalize() { return canon; }
+    TypeName typeName() const { return TypeName(canon); }
     virtual ParamsReturnVal funcInfo() const;
-    virtual ~Type() {}
     friend ostream& operator<<(ostream& os, const Type& obj) {
         obj.print(os);
         return os;
     }
-    virtual string toLIRType() const { return ""; }
+    const string& toLIRType() const { return canon->lir; }
 };
 struct Int : Type {
+    Int() : Type(Kind::Int) { canon = types().integer(); }
+    static bool classof(const Type* n) { return n->kind == Kind::Int; }
     void print(ostream& os) const override {
         os << "Int";
     }
-    TypeName typeName() const override {
-        return TypeName("int");
-    }
-    string toLIRType() const override { return "Int"; }
 };
 struct StructType : Type {
-    string name;
+    SymbolId name;
+    StructType() : Type(Kind::StructType) {}
+    static bool classof(const Type* n) { return n->kind == Kind::StructType; }
     void print(ostream& os) const override { 
         os << "Struct(" << name << ")"; 
     }
-    TypeName typeName() const override {
-        return TypeName(name);
-    }
-    string toLIRType() const override { return "Struct(" + name + ")"; }
+    const CanonType* canonicalize() override { return canon = types().structType(name); }
 };
 struct Fn : Type {
     vector<Type*> prms;
     // WARNING: if there is no return for Fn, ret is Any (look at struct Any : Type)
     Type* ret;
+    Fn() : Type(Kind::Fn) {}
+    static bool classof(const Type* n) { return n->kind == Kind::Fn; }
     void print(ostream& os) const override { 
         os << "Fn(prms = [";
         for (unsigned int i = 0; i < prms.size(); i++) {
@@ -96,309 +158,287 @@ struct Fn : Type {
         }
         os << "], ret = " << *ret << ")";
     }
-    TypeName typeName() const override {
-        string prms_type_names;
-        for (unsigned int i = 0; i < prms.size(); i++) {
-            prms_type_names += prms[i]->typeName().type_name;
-            if (i != prms.size() - 1) prms_type_names += ", ";
-        }
-        string temp = "(" + prms_type_names + ") -> " + ret->typeName().type_name;
-        return TypeName(temp);
+    const CanonType* canonicalize() override {
+        vector<const CanonType*> params;
+        for (Type* prm: prms) params.push_back(prm->canon);
+        return canon = types().fn(params, ret->canon);
     }
     ParamsReturnVal funcInfo () const override { return make_pair(prms, ret); }
-    ~Fn() {
-        for (Type* t: prms) delete t;
-        delete ret;
-    }
-    string toLIRType() const override { 
-        string res = "Fn([";
-        for (unsigned int i = 0; i < prms.size(); i++) {
-            res += prms[i]->toLIRType();
-            if (i != prms.size() - 1) res += ", ";
-        }
-        res += "], " + ret->toLIRType() + ")";
-        return res;
-    }
 };
 struct Ptr : Type {
     Type* ref;
+    Ptr() : Type(Kind::Ptr) {}
+    static bool classof(const Type* n) { return n->kind == Kind::Ptr; }
     void print(ostream& os) const override { 
         os << "Ptr(" << *ref << ")";
     }
-    TypeName typeName() const override {
-        string ptr_type_names;
-        const Type* temp = ref;
-        while (temp) {
-            ptr_type_names += "&";
-            if (dynamic_cast<const Ptr*>(temp)) { // Checks if temp is a pointer type
-                temp = static_cast<const Ptr*>(temp)->ref;
-            } else {
-                ptr_type_names += temp->typeName().type_name;
-                break;
-            }
-        }
-        return TypeName(ptr_type_names);
-    }
+    const CanonType* canonicalize() override { return canon = types().ptr(ref->canon); }
     ParamsReturnVal funcInfo () const override { return ref->funcInfo(); }
-    ~Ptr() { delete ref; }
-    string toLIRType() const override {  return "Ptr(" + ref->toLIRType() + ")"; }
 };
 struct Any : Type {
+    Any() : Type(Kind::Any) { canon = types().any(); }
+    static bool classof(const Type* n) { return n->kind == Kind::Any; }
     void print(ostream& os) const override { 
         os << "_";
     }
-    TypeName typeName() const override {
-        return TypeName("_");
-    }
-    bool isAny() const override { return true; }
-    string toLIRType() const override { return "_"; }
 };
 
 struct UnaryOp {
+    const Kind kind;
+    explicit UnaryOp(Kind kind) : kind(kind) {}
     virtual void print(ostream& os) const {}
-    virtual TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors, Exp* operand) const { return TypeName("_"); };
+    virtual TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors, Exp* operand) const { return TypeName(types().any()); };
     friend ostream& operator<<(ostream& os, const UnaryOp& uo) {
         uo.print(os);
         return os;
     }
-    virtual string toLIRType() const { return ""; }
 };
 struct Neg : UnaryOp {
+    Neg() : UnaryOp(Kind::Neg) {}
+    static bool classof(const UnaryOp* n) { return n->kind == Kind::Neg; }
     void print(ostream& os) const override { os << "Neg"; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors, Exp* operand) const override; //Defined at the bottom
-    string toLIRType() const override { return "neg"; }
 };
 struct UnaryDeref : UnaryOp {
+    UnaryDeref() : UnaryOp(Kind::UnaryDeref) {}
+    static bool classof(const UnaryOp* n) { return n->kind == Kind::UnaryDeref; }
     void print(ostream& os) const override { os << "Deref"; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors, Exp* operand) const override;
-    string toLIRType() const override { return "deref"; }
 };
 
 struct BinaryOp{
+    const Kind kind;
+    explicit BinaryOp(Kind kind) : kind(kind) {}
     virtual void print(ostream& os) const {}
     virtual TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors, Exp* left, Exp* right) const; //define for rest, overload for eq/not eq (defined below)
     friend ostream& operator<<(ostream& os, const BinaryOp& bo) {
         bo.print(os);
         return os;
     }
-    virtual string toLIRType() const { return ""; }
+    LIR::Operator toLIRType() const {
+        switch (kind) {
+            case Kind::Add: return LIR::Operator::Add;
+            case Kind::Sub: return LIR::Operator::Sub;
+            case Kind::Mul: return LIR::Operator::Mul;
+            case Kind::Div: return LIR::Operator::Div;
+            case Kind::Equal: return LIR::Operator::Eq;
+            case Kind::NotEq: return LIR::Operator::Neq;
+            case Kind::Lt: return LIR::Operator::Lt;
+            case Kind::Lte: return LIR::Operator::Lte;
+            case Kind::Gt: return LIR::Operator::Gt;
+            case Kind::Gte: return LIR::Operator::Gte;
+            default: assert(false); return LIR::Operator::Add; // not an operator's kind
+        }
+    }
 };
 struct Add : BinaryOp{
+    Add() : BinaryOp(Kind::Add) {}
+    static bool classof(const BinaryOp* n) { return n->kind == Kind::Add; }
     void print(ostream& os) const override { os << "Add"; }
-    string toLIRType() const override { return "add"; }
 };
 struct Sub : BinaryOp{
+    Sub() : BinaryOp(Kind::Sub) {}
+    static bool classof(const BinaryOp* n) { return n->kind == Kind::Sub; }
     void print(ostream& os) const override { os << "Sub"; }
-    string toLIRType() const override { return "sub"; }
 };
 struct Mul : BinaryOp{
+    Mul() : BinaryOp(Kind::Mul) {}
+    static bool classof(const BinaryOp* n) { return n->kind == Kind::Mul; }
     void print(ostream& os) const override { os << "Mul"; }
-    string toLIRType() const override { return "mul"; }
 };
 struct Div : BinaryOp{
+    Div() : BinaryOp(Kind::Div) {}
+    static bool classof(const BinaryOp* n) { return n->kind == Kind::Div; }
     void print(ostream& os) const override { os << "Div"; }
-    string toLIRType() const override { return "div"; }
 };
 struct Equal : BinaryOp{
+    Equal() : BinaryOp(Kind::Equal) {}
+    static bool classof(const BinaryOp* n) { return n->kind == Kind::Equal || n->kind == Kind::NotEq; }
     void print(ostream& os) const override { os << "Equal"; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors, Exp* left, Exp* right) const override;
-    string toLIRType() const override { return "eq"; }
+  protected:
+    explicit Equal(Kind kind) : BinaryOp(kind) {}
 };
 struct NotEq : Equal{ //so the same typeCheck function is inherited
+    NotEq() : Equal(Kind::NotEq) {}
+    static bool classof(const BinaryOp* n) { return n->kind == Kind::NotEq; }
     void print(ostream& os) const override { os << "NotEq"; }
-    string toLIRType() const override { return "neq"; }
 };
 struct Lt : BinaryOp{
+    Lt() : BinaryOp(Kind::Lt) {}
+    static bool classof(const BinaryOp* n) { return n->kind == Kind::Lt; }
     void print(ostream& os) const override { os << "Lt"; }
-    string toLIRType() const override { return "lt"; }
 };
 struct Lte : BinaryOp{
+    Lte() : BinaryOp(Kind::Lte) {}
+    static bool classof(const BinaryOp* n) { return n->kind == Kind::Lte; }
     void print(ostream& os) const override { os << "Lte"; }
-    string toLIRType() const override { return "lte"; }
 };
 struct Gt : BinaryOp{
+    Gt() : BinaryOp(Kind::Gt) {}
+    static bool classof(const BinaryOp* n) { return n->kind == Kind::Gt; }
     void print(ostream& os) const override { os << "Gt"; }
-    string toLIRType() const override { return "gt"; }
 };
 struct Gte : BinaryOp{
+    Gte() : BinaryOp(Kind::Gte) {}
+    static bool classof(const BinaryOp* n) { return n->kind == Kind::Gte; }
     void print(ostream& os) const override { os << "Gte"; }
-    string toLIRType() const override { return "gte"; }
 };
 
 struct Exp {
+    const Kind kind;
+    // The type typeCheck found for this expression, which lowering reads back
+    // instead of working it out again. Null until the expression is checked.
+    mutable const CanonType* type = nullptr;
+    explicit Exp(Kind kind) : kind(kind) {}
     virtual void print(ostream& os) const {}
-    virtual TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const { return TypeName("_"); };
-    virtual string getName() { return "_"; };
-    virtual bool isAny() const { return false; }
-    virtual bool isFieldAccess() const { return false; }
-    virtual bool isId() const { return false; }
+    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
+        TypeName checked = check(gamma, fun, errors);
+        type = checked.type;
+        return checked;
+    }
+    virtual TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const { return TypeName(types().any()); };
+    virtual SymbolId getName() { return SymbolTable::Underscore; };
     virtual Exp* getPtr() { return nullptr; }
-    virtual ~Exp() {}
     friend ostream& operator<<(ostream& os, const Exp& exp) {
         exp.print(os);
         return os;
     }
-    virtual tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const { return make_tuple(0, "", ""); }
+    virtual pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const { return make_pair(LIR::none(), types().any()); }
 };
 struct Num : Exp {
     int32_t n;
+    Num() : Exp(Kind::Num) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::Num; }
     void print(ostream& os) const override { os << "Num(" << n << ")"; }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override { return TypeName("int"); };
-    string getName() override { return "int"; }
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        return make_tuple(0, to_string(n), "Num");
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override { return TypeName(types().integer()); };
+    SymbolId getName() override { return SymbolTable::Int; }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        return make_pair(LIR::constant(n), types().integer());
     }
 };
 struct ExpId : Exp {
-    string name;
-    ExpId() {}
-    ExpId(const string& name) : name(name) {}
+    SymbolId name;
+    static bool classof(const Exp* n) { return n->kind == Kind::ExpId; }
+    ExpId() : Exp(Kind::ExpId) {}
+    ExpId(SymbolId name) : Exp(Kind::ExpId), name(name) {}
     void print(ostream& os) const override { os << "Id(" << name << ")"; }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    string getName() override { return name; }
-    virtual bool isId() const { return true; }
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        return make_tuple(0, name, gamma[name]->toLIRType()); 
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override;
+    SymbolId getName() override { return name; }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        return make_pair(LIR::var(name), gamma.at(name)->canon);
     }
 };
 struct Nil : Exp {
+    Nil() : Exp(Kind::Nil) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::Nil; }
     void print(ostream& os) const override { os << "Nil"; }
-    TypeName typeName() const { return TypeName("&_"); }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override { return TypeName("&_");};
-    string getName() override { return "_"; }
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        return make_tuple(0, "0", "_"); 
+    TypeName typeName() const { return TypeName(types().nil()); }
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override { return TypeName(types().nil());};
+    SymbolId getName() override { return SymbolTable::Underscore; }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        return make_pair(LIR::constant(0), types().any());
     }
 };
 struct UnOp : Exp {
-    UnaryOp* op;
+    const UnaryOp* op; // shared, see singleton()
     Exp* operand;
+    UnOp() : Exp(Kind::UnOp) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::UnOp; }
     void print(ostream& os) const override { os << *op << "(" << *operand << ")"; }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override {
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override {
         return op->typeCheck(gamma, fun, errors, operand);
     }
-    string getName() override { return operand->getName(); }
-    ~UnOp() { delete operand; }
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        string res = "";
-        string lhs_type = "";
-        if (op->toLIRType() == "neg") {
-            tempsToType.push_back("!");
+    SymbolId getName() override { return operand->getName(); }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        const CanonType* lhs_type = nullptr;
+        if (isa<Neg>(op)) {
+            tempsToType.push_back(nullptr);
             unsigned int fresh_var = tempsToType.size();
-            auto [eval_var_src, eval_string_src, op_type] = operand->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-            if (eval_var_src != 0) {
-                res += eval_string_src; //building the res instructions
-                eval_string_src = "_t" + to_string(eval_var_src); //now used for old var
-            }
-            lhs_type = "Int";
+            auto [src, op_type] = operand->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+            lhs_type = types().integer();
             tempsToType[fresh_var-1] = lhs_type;
-            res += "    Arith(_t" + to_string(fresh_var) + ", sub, 0, " + eval_string_src + ")\n";                  
-            return make_tuple(fresh_var, res, lhs_type);
+            code.emit(LIR::Arith(LIR::temp(fresh_var), LIR::Operator::Sub, LIR::constant(0), src));
+            return make_pair(LIR::temp(fresh_var), lhs_type);
         }
         else {
-            auto [eval_var_src, eval_string_src, op_type] = operand->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-            if (eval_var_src != 0) {
-                res += eval_string_src; //building the res instructions
-                eval_string_src = "_t" + to_string(eval_var_src);
-            }
-            lhs_type = op_type.substr(4, op_type.length() - 5);
+            auto [src, op_type] = operand->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+            lhs_type = type;
             tempsToType.push_back(lhs_type);
             unsigned int fresh_var = tempsToType.size();
-            res += "    Load(_t" + to_string(fresh_var) + ", " + eval_string_src + ")\n";  
-            // cout << "Current res:\n" << res << "\n";
-            return make_tuple(fresh_var, res, lhs_type); //returning new type
+            code.emit(LIR::Load(LIR::temp(fresh_var), src));
+            return make_pair(LIR::temp(fresh_var), lhs_type); //returning new type
         }
-        return make_tuple(0, "", ""); 
+        return make_pair(LIR::none(), types().any());
     }
 };
 struct BinOp : Exp {
-    BinaryOp* op;
+    const BinaryOp* op; // shared, see singleton()
     Exp* left;
     Exp* right;
+    BinOp() : Exp(Kind::BinOp) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::BinOp; }
     void print(ostream& os) const override {
         os << "BinOp(\nop = " << *op << ",\nleft = " << *left << ",\nright = " << *right << "\n)"; 
     }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override {
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override {
         return op->typeCheck(gamma, fun, errors, left, right);
     }
-    string getName() override { return "_"; }
-    ~BinOp() { delete left; delete right; }
+    SymbolId getName() override { return SymbolTable::Underscore; }
     
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        auto [eval_var_left, eval_string_left, _] = left->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        auto [eval_var_right, eval_string_right, _2] = right->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        string opType = op->toLIRType();
-        string res = "";
-        string lhs_type = "Int";
-        if (eval_var_left != 0) {
-            res += eval_string_left;
-            eval_string_left = "_t" + to_string(eval_var_left);
-        }
-        if (eval_var_right != 0) {
-            res += eval_string_right;
-            eval_string_right = "_t" + to_string(eval_var_right);
-        }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        auto [left_op, _] = left->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        auto [right_op, _2] = right->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        const CanonType* lhs_type = types().integer();
         tempsToType.push_back(lhs_type);
         unsigned int fresh_var = tempsToType.size();
-        if (opType == "add" || opType == "sub" || opType == "mul" || opType == "div") {
-            res += "    Arith(_t" + to_string(fresh_var) + ", " + opType + ", " + eval_string_left + ", " + eval_string_right + ")\n";
-        }
-        else {
-            res += "    Cmp(_t" + to_string(fresh_var) + ", " + opType + ", " + eval_string_left + ", " + eval_string_right + ")\n";
-        }
-        return make_tuple(fresh_var, res, lhs_type);        
+        code.emit(LIR::Arith(LIR::temp(fresh_var), op->toLIRType(), left_op, right_op)); // a Cmp for the comparisons
+        return make_pair(LIR::temp(fresh_var), lhs_type);
     }
 };
 struct ExpArrayAccess : Exp {
     Exp* ptr;
     Exp* index;
+    ExpArrayAccess() : Exp(Kind::ExpArrayAccess) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::ExpArrayAccess; }
     void print(ostream& os) const override {
         os << "ArrayAccess(\nptr = " << *ptr << ",\nindex = " << *index << "\n)";
     }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    string getName() override { return ptr->getName(); }
-    ~ExpArrayAccess() { delete ptr; delete index; }
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override;
+    SymbolId getName() override { return ptr->getName(); }
     
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        auto [eval_var_src, eval_string_src, src_type] = ptr->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        auto [eval_var_idx, eval_string_idx, _] = index->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        string res = "";
-        string lhs_type = "";
-        if (eval_var_src != 0) {
-            res += eval_string_src;
-            eval_string_src = "_t" + to_string(eval_var_src);
-        }
-        if (eval_var_idx != 0) {
-            res += eval_string_idx;
-            eval_string_idx = "_t" + to_string(eval_var_idx);
-        }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        auto [src, src_type] = ptr->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        auto [idx, _] = index->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
         tempsToType.push_back(src_type);
         unsigned int fresh_var_elem = tempsToType.size();
-        lhs_type = src_type.substr(4, src_type.length() - 5);
+        const CanonType* lhs_type = type;
         tempsToType.push_back(lhs_type);
         unsigned int fresh_var_lhs = tempsToType.size();
-        res += "    Gep(_t" + to_string(fresh_var_elem) + ", " + eval_string_src + ", " + eval_string_idx + ")\n";
-        res += "    Load(_t" + to_string(fresh_var_lhs) + ", _t" + to_string(fresh_var_elem) + ")\n";
-        return make_tuple(fresh_var_lhs, res, lhs_type);
+        code.emit(LIR::Gep(LIR::temp(fresh_var_elem), src, idx));
+        code.emit(LIR::Load(LIR::temp(fresh_var_lhs), LIR::temp(fresh_var_elem)));
+        return make_pair(LIR::temp(fresh_var_lhs), lhs_type);
     }
 };
 struct ExpFieldAccess : Exp {
     Exp* ptr;
-    string field;
+    SymbolId field;
+    ExpFieldAccess() : Exp(Kind::ExpFieldAccess) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::ExpFieldAccess; }
     void print(ostream& os) const override {
         os << "FieldAccess(\nptr = " << *ptr << ",\nfield = " << field << "\n)";
     }
-    bool isFieldAccess() const override { return true; }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    string getName() override { return field; }
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override;
+    SymbolId getName() override { return field; }
     Exp* getPtr() override { return ptr; }
-    ~ExpFieldAccess() { delete ptr; }
     
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const;
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const;
 };
 struct ExpCall : Exp {
     Exp* callee;
     vector<Exp*> args;
+    ExpCall() : Exp(Kind::ExpCall) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::ExpCall; }
     void print(ostream& os) const override {
         os << "Call(\ncallee = " << *callee << ",\nargs = [";
         for (unsigned int i = 0; i < args.size(); i++) {
@@ -407,123 +447,114 @@ struct ExpCall : Exp {
         }
         os << "\n]\n)";
     }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    ~ExpCall() {
-        delete callee;
-        for (Exp* exp: args) delete exp;
-    }
-    string getName() override { return callee->getName(); }
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override;
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override;
+    SymbolId getName() override { return callee->getName(); }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override;
 };
 struct AnyExp : Exp {
+    AnyExp() : Exp(Kind::AnyExp) {}
+    static bool classof(const Exp* n) { return n->kind == Kind::AnyExp; }
     void print(ostream& os) const override { os << "_"; }
-    TypeName typeName() const { return TypeName("_"); }
-    bool isAny() const override { return true; }
-    string getName() override { return "_"; }
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        return make_tuple(0, "_", "_"); 
+    TypeName typeName() const { return TypeName(types().any()); }
+    SymbolId getName() override { return SymbolTable::Underscore; }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        return make_pair(LIR::none(), types().any());
     }
 };
 struct Lval {
+    const Kind kind;
+    // As for Exp: the type of the location, recorded by typeCheck for lowering
+    mutable const CanonType* type = nullptr;
+    explicit Lval(Kind kind) : kind(kind) {}
     virtual void print(ostream& os) const {}
-    virtual TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const { return TypeName("_"); };
-    virtual string getName() { return "_"; }
-    virtual bool isFieldAccess() const { return false; }
-    virtual bool isId() const { return false; }
+    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
+        TypeName checked = check(gamma, fun, errors);
+        type = checked.type;
+        return checked;
+    }
+    virtual TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const { return TypeName(types().any()); };
+    virtual SymbolId getName() { return SymbolTable::Underscore; }
     virtual Lval* getPtr() { return nullptr; }
-    virtual ~Lval() {}
     friend ostream& operator<<(ostream& os, const Lval& lval) {
         lval.print(os);
         return os;
     }
-    virtual tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const {
-        return make_tuple(0, "_", "_"); 
-    }
-    tuple<unsigned int, string, string> le(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, Lval* lval, map<string, string>& extern_map, map<string, string>& function_map) const {
-        auto [eval_var_src, eval_string_src, op_type] = lval->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        if (lval->isId()) { return make_tuple(eval_var_src, eval_string_src, op_type); }
-        string res = "";
-        string lhs_type;
-        if (eval_var_src != 0) {
-            res += eval_string_src; //building the res instructions
-            eval_string_src = "_t" + to_string(eval_var_src);
-        }
-        lhs_type = op_type.substr(4, op_type.length() - 5);
+    virtual pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const {
+        return make_pair(LIR::none(), types().any());
+    }
+    pair<LIR::Operand, const CanonType*> le(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, Lval* lval, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const {
+        auto [src, op_type] = lval->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        if (lval->kind == Kind::LvalId) { return make_pair(src, op_type); }
+        const CanonType* lhs_type = lval->type;
         //Create fresh type of type t std src:&t
         tempsToType.push_back(lhs_type);
         unsigned int fresh_var = tempsToType.size();
-        res += "    Load(_t" + to_string(fresh_var) + ", " + eval_string_src + ")\n";  
-        return make_tuple(fresh_var, res, lhs_type); //returning new type
+        code.emit(LIR::Load(LIR::temp(fresh_var), src));
+        return make_pair(LIR::temp(fresh_var), lhs_type); //returning new type
     }
 };
 struct LvalId : Lval {
-    string name;
+    SymbolId name;
+    LvalId() : Lval(Kind::LvalId) {}
+    static bool classof(const Lval* n) { return n->kind == Kind::LvalId; }
     void print(ostream& os) const override { os << "Id(" << name << ")"; }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    string getName() override { return name; }
-    bool isId() const override { return true; }
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        return make_tuple(0, name, gamma[name]->toLIRType()); 
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override;
+    SymbolId getName() override { return name; }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        return make_pair(LIR::var(name), gamma.at(name)->canon);
     }
 };
 struct LvalDeref : Lval {
     Lval* lval;
+    LvalDeref() : Lval(Kind::LvalDeref) {}
+    static bool classof(const Lval* n) { return n->kind == Kind::LvalDeref; }
     void print(ostream& os) const override { os << "Deref(" << *lval << ")"; }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    string getName() override { return lval->getName(); }
-    ~LvalDeref() { delete lval; }
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        return le(tempsToType, numLabels, gamma, fun, lval, extern_map, function_map);
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override;
+    SymbolId getName() override { return lval->getName(); }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        return le(code, tempsToType, numLabels, gamma, fun, lval, extern_map, function_names);
     }
 };
 struct LvalArrayAccess : Lval {
     Lval* ptr;
     Exp* index;
+    LvalArrayAccess() : Lval(Kind::LvalArrayAccess) {}
+    static bool classof(const Lval* n) { return n->kind == Kind::LvalArrayAccess; }
     void print(ostream& os) const override {
         os << "ArrayAccess(\nptr = " << *ptr << ",\nindex = " << *index << "\n)";
     }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    string getName() override { return ptr->getName(); }
-    ~LvalArrayAccess() { delete ptr; delete index; }
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        auto [eval_var_src, eval_string_src, src_type] = le(tempsToType, numLabels, gamma, fun, ptr, extern_map, function_map);
-        auto [eval_var_idx, eval_string_idx, _] = index->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        string res = "";
-        string lhs_type = "";
-        if (eval_var_src != 0) {
-            res += eval_string_src;
-            eval_string_src = "_t" + to_string(eval_var_src);
-        }
-        if (eval_var_idx != 0) {
-            res += eval_string_idx;
-            eval_string_idx = "_t" + to_string(eval_var_idx);
-        }
-        lhs_type = src_type;
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override;
+    SymbolId getName() override { return ptr->getName(); }
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        auto [src, src_type] = le(code, tempsToType, numLabels, gamma, fun, ptr, extern_map, function_names);
+        auto [idx, _] = index->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        const CanonType* lhs_type = src_type;
         tempsToType.push_back(lhs_type);
         unsigned int fresh_var_lhs = tempsToType.size();
-        res += "    Gep(_t" + to_string(fresh_var_lhs) + ", " + eval_string_src + ", " + eval_string_idx + ")\n";
-        return make_tuple(fresh_var_lhs, res, lhs_type);
+        code.emit(LIR::Gep(LIR::temp(fresh_var_lhs), src, idx));
+        return make_pair(LIR::temp(fresh_var_lhs), lhs_type);
     }
 };
 struct LvalFieldAccess : Lval {
     Lval* ptr;
-    string field;
+    SymbolId field;
+    LvalFieldAccess() : Lval(Kind::LvalFieldAccess) {}
+    static bool classof(const Lval* n) { return n->kind == Kind::LvalFieldAccess; }
     void print(ostream& os) const override {
         os << "FieldAccess(\nptr = " << *ptr << ",\nfield = " << field << "\n)";
     }
-    string getName() override { return ptr->getName(); }
+    SymbolId getName() override { return ptr->getName(); }
     Lval* getPtr() override { return ptr; }
-    bool isFieldAccess() const override { return false;  }
-    TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    ~LvalFieldAccess() { delete ptr; }
-    tuple<unsigned int, string, string> lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const override;
+    TypeName check(Gamma& gamma, const Function* fun, Errors& errors) const override;
+    pair<LIR::Operand, const CanonType*> lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override;
 };
 
 
 struct Rhs {
+    const Kind kind;
+    explicit Rhs(Kind kind) : kind(kind) {}
     virtual void print(ostream& os) const {}
-    virtual TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const { return TypeName("_"); };
-    virtual ~Rhs() {}
+    virtual TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const { return TypeName(types().any()); };
     friend ostream& operator<<(ostream& os, const Rhs& rhs) {
         rhs.print(os);
         return os;
@@ -531,114 +562,117 @@ struct Rhs {
 };
 struct RhsExp : Rhs {
     Exp* exp;
+    RhsExp() : Rhs(Kind::RhsExp) {}
+    static bool classof(const Rhs* n) { return n->kind == Kind::RhsExp; }
     void print(ostream& os) const override { os << *exp; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    ~RhsExp() { delete exp; }
 };
 struct New : Rhs {
     Type* type;
     Exp* amount;
+    New() : Rhs(Kind::New) {}
+    static bool classof(const Rhs* n) { return n->kind == Kind::New; }
     void print(ostream& os) const override { os << "New(" << *type << ", " << *amount << ")"; }
     TypeName typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const override;
-    ~New() { delete type; delete amount; }
 };
 
 struct Stmt {
+    const Kind kind;
+    explicit Stmt(Kind kind) : kind(kind) {}
     virtual void print(ostream& os) const {}
     virtual bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const { return true; };
-    virtual string getName() { return "_"; }
-    virtual ~Stmt() {}
+    virtual SymbolId getName() { return SymbolTable::Underscore; }
     friend ostream& operator<<(ostream& os, const Stmt& stmt) {
         stmt.print(os);
         return os;
     }
-    virtual string lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, map<string, string>& extern_map, map<string, string>& function_map) const {
-        return "?\n"; 
+    virtual void lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const {
+        code.emit(LIR::Unknown());
     }
 };
 struct Break : Stmt {
+    Break() : Stmt(Kind::Break) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::Break; }
     void print(ostream& os) const override { os << "Break"; }
     virtual bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    string lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        if (prevWhileEnd != 0) return "    Jump(lbl" + to_string(prevWhileEnd) + ")\n";
-        return "?\n"; 
+    void lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        if (prevWhileEnd != 0) code.emit(LIR::Jump(prevWhileEnd));
+        else code.emit(LIR::Unknown());
     }
 };
 struct Continue : Stmt {
+    Continue() : Stmt(Kind::Continue) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::Continue; }
     void print(ostream& os) const override { os << "Continue"; }
     virtual bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    string lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        if (prevWhileHdr != 0) return "    Jump(lbl" + to_string(prevWhileHdr) + ")\n";
-        return "?\n";
+    void lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        if (prevWhileHdr != 0) code.emit(LIR::Jump(prevWhileHdr));
+        else code.emit(LIR::Unknown());
     }
 };
 struct Return : Stmt {
     // WARNING: if there is no return, exp is AnyExp : Exp
     Exp* exp;
+    Return() : Stmt(Kind::Return) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::Return; }
     void print(ostream& os) const override {
         os << "Return(" << *exp << ")";
     }
     bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    ~Return() { delete exp; }
-    string lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, map<string, string>& extern_map, map<string, string>& function_map) const override {
-        if (typeid(*exp) == typeid(AnyExp)) {
-            return "    Ret(_)\n";
+    void lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
+        if (isa<AnyExp>(exp)) {
+            code.emit(LIR::Ret(LIR::none()));
+            return;
         }
-        auto [temp_var, res_string, _] = exp->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        string res = "";
-        if (temp_var != 0) {res += res_string; res_string = "_t" + to_string(temp_var); }
-        res += "    Ret(" + res_string + ")\n";
-        return res;
+        auto [value, _] = exp->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        code.emit(LIR::Ret(value));
     }
 };
 struct Assign : Stmt {
     Lval* lhs;
     Rhs* rhs;
+    Assign() : Stmt(Kind::Assign) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::Assign; }
     void print(ostream& os) const override {
         os << "Assign(\nlhs = " << *lhs << ",\nrhs = " << *rhs << "\n)";
     }
     bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    ~Assign() { delete lhs; delete rhs; }
-    string lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, map<string, string>& extern_map, map<string, string>& function_map) const override {
+    void lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
         // Assign(lhs, New(typ, e))
-        if (New* n = dynamic_cast<New*>(rhs)) {
-            if (LvalId* lvalid = dynamic_cast<LvalId*>(lhs)) {
-                auto [temp_var, res_string, _] = n->amount->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-                if (temp_var == 0) return "    Alloc(" + lvalid->name + ", " + res_string + ")\n";
-                return res_string + "    Alloc(" + lvalid->name + ", _t" + to_string(temp_var) + ")\n";
+        if (New* n = dyn_cast<New>(rhs)) {
+            if (LvalId* lvalid = dyn_cast<LvalId>(lhs)) {
+                auto [amount, _] = n->amount->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+                code.emit(LIR::Alloc(LIR::var(lvalid->name), amount));
+                return;
             }
-            tempsToType.push_back("Ptr(" + n->type->toLIRType() + ")");
+            tempsToType.push_back(types().ptr(n->type->canon));
             unsigned int w = tempsToType.size();
-            auto [x_var, x_string, x_type] = lhs->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-            auto [y_var, y_string, y_type] = n->amount->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-            string res = "";
-            if (x_var != 0) { res += x_string; x_string = "_t" + to_string(x_var); }
-            if (y_var != 0) { res += y_string; y_string = "_t" + to_string(y_var); }
-            res += "    Alloc(_t" + to_string(w) + ", " + y_string + ")\n";
-            res += "    Store(" + x_string + ", _t" + to_string(w) + ")\n";
-            return res;
+            auto [x, x_type] = lhs->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+            auto [y, y_type] = n->amount->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+            code.emit(LIR::Alloc(LIR::temp(w), y));
+            code.emit(LIR::Store(x, LIR::temp(w)));
+            return;
         }
         // Assign(lhs, RhsExp(e))
-        else if (RhsExp* rhsexp = dynamic_cast<RhsExp*>(rhs)) {
-            if (LvalId* lvalid = dynamic_cast<LvalId*>(lhs)) {
-                auto [temp_var, res_string, _] = rhsexp->exp->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-                if (temp_var == 0) return "    Copy(" + lvalid->name + ", " + res_string + ")\n";
-                return res_string + "    Copy(" + lvalid->name + ", _t" + to_string(temp_var) + ")\n";
+        else if (RhsExp* rhsexp = dyn_cast<RhsExp>(rhs)) {
+            if (LvalId* lvalid = dyn_cast<LvalId>(lhs)) {
+                auto [value, _] = rhsexp->exp->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+                code.emit(LIR::Copy(LIR::var(lvalid->name), value));
+                return;
             }
-            auto [x_var, x_string, x_type] = lhs->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-            auto [y_var, y_string, y_type] = rhsexp->exp->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-            string res = "";
-            if (x_var != 0) { res += x_string; x_string = "_t" + to_string(x_var); }
-            if (y_var != 0) { res += y_string; y_string = "_t" + to_string(y_var); }
-            res += "    Store(" + x_string + ", " + y_string + ")\n";
-            return res;
+            auto [x, x_type] = lhs->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+            auto [y, y_type] = rhsexp->exp->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+            code.emit(LIR::Store(x, y));
+            return;
         }
-        return "?\n"; 
+        code.emit(LIR::Unknown());
     }
 };
 struct StmtCall : Stmt {
     Lval* callee;
     vector<Exp*> args;
+    StmtCall() : Stmt(Kind::StmtCall) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::StmtCall; }
     void print(ostream& os) const override {
         os << "Call(\ncallee = " << *callee << ",\nargs = [";
         for (unsigned int i = 0; i < args.size(); i++) {
@@ -647,15 +681,16 @@ struct StmtCall : Stmt {
         }
         os << "]\n)";
     }
-    string getName() override { return callee->getName(); }
+    SymbolId getName() override { return callee->getName(); }
     bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    ~StmtCall() { delete callee; for (Exp* exp: args) delete exp; }
-    string lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, map<string, string>& extern_map, map<string, string>& function_map) const override;
+    void lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override;
 };
 struct If : Stmt {
     Exp* guard;
     vector<Stmt*> tt;
     vector<Stmt*> ff;
+    If() : Stmt(Kind::If) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::If; }
     void print(ostream& os) const override {
         os << "If(\nguard = " << *guard << ",\ntt = [";
         for (unsigned int i = 0; i < tt.size(); i++) {
@@ -670,29 +705,27 @@ struct If : Stmt {
         os << "]\n)";
     }
     bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    ~If() { delete guard; for (Stmt* stmt: tt) delete stmt; for (Stmt* stmt: ff) delete stmt; }
-    string lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, map<string, string>& extern_map, map<string, string>& function_map) const override {
+    void lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
         unsigned int TT = numLabels + 1;
         unsigned int FF = numLabels + 2;
         unsigned int IF_END = numLabels + 3;
         numLabels += 3;
-        auto [guard_var, guard_string, guard_type] = guard->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        string res = "";
-        if (guard_var != 0) { res += guard_string; guard_string = "_t" + to_string(guard_var); }
-        res += "    Branch(" + guard_string + ", lbl" + to_string(TT) + ", lbl" + to_string(FF) + ")\n";
-        res += "\n  lbl" + to_string(TT) + ":\n";
-        for (Stmt* stmt: tt) res += stmt->lower(tempsToType, numLabels, gamma, fun, prevWhileHdr, prevWhileEnd, extern_map, function_map);
-        res += "    Jump(lbl" + to_string(IF_END) + ")\n";
-        res += "\n  lbl" + to_string(FF) + ":\n";
-        for (Stmt* stmt: ff) res += stmt->lower(tempsToType, numLabels, gamma, fun, prevWhileHdr, prevWhileEnd, extern_map, function_map);
-        res += "    Jump(lbl" + to_string(IF_END) + ")\n";
-        res += "\n  lbl" + to_string(IF_END) + ":\n";
-        return res;
+        auto [guard_op, guard_type] = guard->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        code.emit(LIR::Branch(guard_op, TT, FF));
+        code.label(TT);
+        for (Stmt* stmt: tt) stmt->lower(code, tempsToType, numLabels, gamma, fun, prevWhileHdr, prevWhileEnd, extern_map, function_names);
+        code.emit(LIR::Jump(IF_END));
+        code.label(FF);
+        for (Stmt* stmt: ff) stmt->lower(code, tempsToType, numLabels, gamma, fun, prevWhileHdr, prevWhileEnd, extern_map, function_names);
+        code.emit(LIR::Jump(IF_END));
+        code.label(IF_END);
     }
 };
 struct While : Stmt {
     Exp* guard;
     vector<Stmt*> body;
+    While() : Stmt(Kind::While) {}
+    static bool classof(const Stmt* n) { return n->kind == Kind::While; }
     void print(ostream& os) const override {
         os << "While(\nguard = " << *guard << ",\nbody = [";
         for (unsigned int i = 0; i < body.size(); i++) {
@@ -702,34 +735,33 @@ struct While : Stmt {
         os << "]\n)";
     }
     bool typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const override;
-    ~While() { delete guard; for (Stmt* stmt: body) delete stmt; }
-    string lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, map<string, string>& extern_map, map<string, string>& function_map) const override {
+    void lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const override {
         unsigned int WHILE_HDR = numLabels + 1;
         unsigned int WHILE_BODY = numLabels + 2;
         unsigned int WHILE_END = numLabels + 3;
         numLabels += 3;
+        // break and continue after this loop, in an enclosing one, go to that loop's labels
+        unsigned int outerHdr = prevWhileHdr, outerEnd = prevWhileEnd;
         prevWhileHdr = WHILE_HDR;
         prevWhileEnd = WHILE_END;
-        string res = "";
-        res += "    Jump(lbl" + to_string(WHILE_HDR) + ")\n";
-        res += "\n  lbl" + to_string(WHILE_HDR) + ":\n";
-        auto [guard_var, guard_string, guard_type] = guard->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        if (guard_var != 0) { res += guard_string; guard_string = "_t" + to_string(guard_var); }
-        res += "    Branch(" + guard_string + ", lbl" + to_string(WHILE_BODY) + ", lbl" + to_string(WHILE_END) + ")\n";
-        res += "\n  lbl" + to_string(WHILE_BODY) + ":\n";
-        for (Stmt* stmt: body) res += stmt->lower(tempsToType, numLabels, gamma, fun, prevWhileHdr, prevWhileEnd, extern_map, function_map);
-        res += "    Jump(lbl" + to_string(WHILE_HDR) + ")\n";
-        res += "\n  lbl" + to_string(WHILE_END) + ":\n";
-        return res;
+        code.emit(LIR::Jump(WHILE_HDR));
+        code.label(WHILE_HDR);
+        auto [guard_op, guard_type] = guard->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        code.emit(LIR::Branch(guard_op, WHILE_BODY, WHILE_END));
+        code.label(WHILE_BODY);
+        for (Stmt* stmt: body) stmt->lower(code, tempsToType, numLabels, gamma, fun, prevWhileHdr, prevWhileEnd, extern_map, function_names);
+        code.emit(LIR::Jump(WHILE_HDR));
+        code.label(WHILE_END);
+        prevWhileHdr = outerHdr;
+        prevWhileEnd = outerEnd;
     }
 };
 
 struct Decl {
     // WARNING: should only call its own typename
-    string name;
+    SymbolId name;
     Type* type; // Fn type if this Decl is an extern
     vector<Decl*> params; // optional, used to keep track of parameters for extern decl
-    ~Decl() { delete type; }
     friend ostream& operator<<(ostream& os, const Decl& decl) {
         os << "Decl(" << decl.name << ", " << *(decl.type) << ")";
         return os;
@@ -739,9 +771,8 @@ struct Decl {
 };
 
 struct Struct {
-    string name;
+    SymbolId name;
     vector<Decl*> fields;
-    ~Struct() { for (Decl* decl: fields) delete decl; }
     friend ostream& operator<<(ostream& os, const Struct& str) {
         os << "Struct(\nname = " << str.name << ",\nfields = [";
         for (unsigned int i = 0; i < str.fields.size(); i++) {
@@ -751,33 +782,25 @@ struct Struct {
         os << "]\n)";
         return os;
     }
-    TypeName typeName() const { return TypeName(name); }
+    TypeName typeName() const { return TypeName(types().structType(name)); }
     bool typeCheck(Gamma& gamma, Errors& errors) const;
 };
 
 struct Function {
-    string name;
+    SymbolId name;
     vector<Decl*> params;
     // WARNING: if function has no return type, rettyp is Any : Type
     Type* rettyp;
     // WARNING: for each local, if there is no value after declaration, Exp is AnyExp : Exp
     vector<pair<Decl*, Exp*>> locals;
     vector<Stmt*> stmts;
-    string toLIRType() const {
-        string res = "Fn([";
-        for (unsigned int i = 0; i < params.size(); i++) {
-            res += params[i]->type->toLIRType();
-            if (i != params.size() - 1) res += ", ";
-        }
-        res += "], " + rettyp->toLIRType() + ")";
-        return res;
-    }
-    ~Function() {
-        for (Decl* decl: params) delete decl;
-        delete rettyp;
-        for (auto [decl, exp]: locals) { delete decl; delete exp; }
-        for (Stmt* stmt: stmts) delete stmt;
+    // The function's own type, (params) -> rettyp
+    const CanonType* canonical() const {
+        vector<const CanonType*> prms;
+        for (Decl* decl: params) prms.push_back(decl->type->canon);
+        return types().fn(prms, rettyp->canon);
     }
+    const string& toLIRType() const { return canonical()->lir; }
     friend ostream& operator<<(ostream& os, const Function& func) {
         os << "Function(\nname = " << func.name << ",\nparams = [";
         for (unsigned int i = 0; i < func.params.size(); i++) {
@@ -797,14 +820,7 @@ struct Function {
         os << "]\n)";
         return os;
     }
-    TypeName typeName() const {
-        string prms_type_names;
-        for (unsigned int i = 0; i < params.size(); i++) {
-            prms_type_names += params[i]->typeName().type_name;
-            if (i != params.size() - 1) prms_type_names += ", ";
-        }
-        return TypeName("&(" + prms_type_names + ") -> " + rettyp->typeName().type_name); //Functions should return a pointer to a function
-    }
+    TypeName typeName() const { return TypeName(types().ptr(canonical())); } //Functions should return a pointer to a function
     ParamsReturnVal funcInfo () const { 
         vector<Type*> prms;
         for (Decl* decl: params) {
@@ -812,13 +828,19 @@ struct Function {
         }
         return make_pair(prms, rettyp); 
     }
-    Type* functionType() {
-        Fn* fun = new Fn();
+    // The type node for the function's name, a pointer to the function as
+    // typeName() has it, made in the arena of the Program that holds the function
+    Type* functionType(Arena& arena) const {
+        Fn* fun = arena.make<Fn>();
         for (Decl* decl: params) {
             fun->prms.push_back(decl->type);
         }
         fun->ret = rettyp;
-        return static_cast<Type*>(fun);
+        fun->canonicalize();
+        Ptr* ptr = arena.make<Ptr>();
+        ptr->ref = fun;
+        ptr->canonicalize();
+        return static_cast<Type*>(ptr);
     }
     bool typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const;
 };
@@ -828,12 +850,9 @@ struct Program {
     vector<Struct*> structs;
     vector<Decl*> externs;
     vector<Function*> functions;
-    ~Program() {
-        for (Decl* decl: globals) delete decl;
-        for (Struct* str: structs) delete str;
-        for (Decl* decl: externs) delete decl;
-        for (Function* function: functions) delete function;
-    }
+    // Owns every node of the tree but the shared singletons; they are all freed
+    // together with the Program
+    Arena arena;
     friend ostream& operator<<(ostream& os, const Program& prog) {
         os << "Program(\nglobals = [";
         for (unsigned int i = 0; i < prog.globals.size(); i++) {
@@ -858,18 +877,19 @@ struct Program {
         os << "]\n)";
         return os;
     }
-    bool typeCheck(Gamma& gamma, Errors& errors, unordered_map<string, Gamma>& locals_map) const;
+    // Functions are checked on up to threads threads; the errors come out the same either way
+    bool typeCheck(Gamma& gamma, Errors& errors, unordered_map<SymbolId, Gamma>& locals_map, unsigned threads = 1) const;
 };
 
 }
 
 using namespace AST;
 using ParamsReturnVal = pair<vector<Type*>, Type*>;
-using Gamma = unordered_map<string, Type*>;
-using Delta = unordered_map<string, Gamma>;
+using Gamma = Scope<SymbolId, Type*>; // a function's names over the globals, see Scope
+using Delta = unordered_map<SymbolId, Gamma>;
 using Errors = vector<string>;
-using FunctionsInfo = unordered_map<string, ParamsReturnVal>;
-using StructFunctionsInfo = unordered_map<string, FunctionsInfo>;
+using FunctionsInfo = unordered_map<SymbolId, ParamsReturnVal>;
+using StructFunctionsInfo = unordered_map<SymbolId, FunctionsInfo>;
 
 extern Delta delta;
 extern FunctionsInfo functions_map;
@@ -877,186 +897,208 @@ extern StructFunctionsInfo struct_functions_map;
 
 // General functions (with _TC for ones used by both Exp and Stmt) which depend on earlier definitions
 ParamsReturnVal Type::funcInfo () const {
-    return make_pair(vector<Type*>(), new Any());
+    return make_pair(vector<Type*>(), singleton<Any>());
 }
 
 TypeName RhsExp::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
     return exp->typeCheck(gamma, fun, errors);
 }
 
-TypeName const id_TC(Gamma& gamma, const Function* fun, Errors& errors, string name) {
-    try {
-        return TypeName(gamma.at(name)->typeName()); //Returns TypeName* struct
-    } catch (const out_of_range& e) {
-        errors.push_back("[ID] in function " + fun->name + ": variable " + name + " undefined");
-        return TypeName("_");
-    }
+TypeName const id_TC(Gamma& gamma, const Function* fun, Errors& errors, SymbolId name) {
+    if (Type* const* type = gamma.find(name)) return (*type)->typeName();
+    errors.push_back("[ID] in function " + fun->name.str() + ": variable " + name.str() + " undefined");
+    return TypeName(types().any());
 }
-TypeName ExpId::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
+TypeName ExpId::check(Gamma& gamma, const Function* fun, Errors& errors) const {
     return id_TC(gamma, fun, errors, name);
 };
-TypeName LvalId::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
+TypeName LvalId::check(Gamma& gamma, const Function* fun, Errors& errors) const {
     return id_TC(gamma, fun, errors, name);
 };
 
 TypeName const deref_TC(Gamma& gamma, const Function* fun, Errors& errors, variant<Exp*, Lval*> operand) {
     TypeName exp_type = visit([&exp_type, &gamma, &fun, &errors](auto* arg) { return arg->typeCheck(gamma, fun, errors); }, operand);
-    if (exp_type.type_name == "_") { return exp_type; }
-    if ( exp_type != TypeName("&_") && exp_type.type_name[0] != '&') {
-        errors.push_back("[DEREF] in function " + fun->name + ": dereferencing type " + exp_type.type_name + " instead of pointer");
-        return TypeName("_");
+    if (exp_type.type->isAny()) { return exp_type; }
+    if (!exp_type.type->isPtr()) {
+        errors.push_back("[DEREF] in function " + fun->name.str() + ": dereferencing type " + exp_type.str() + " instead of pointer");
+        return TypeName(types().any());
     }
-    return TypeName( exp_type.type_name.substr(1) );
+    return TypeName(exp_type.type->ref);
 }
 TypeName UnaryDeref::typeCheck(Gamma& gamma, const Function* fun, Errors& errors, Exp* operand) const {
     return deref_TC(gamma, fun, errors, operand);
 }
-TypeName LvalDeref::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
+TypeName LvalDeref::check(Gamma& gamma, const Function* fun, Errors& errors) const {
     return deref_TC(gamma, fun, errors, lval);
 }
 
 TypeName Neg::typeCheck(Gamma& gamma, const Function* fun, Errors& errors, Exp* operand) const {
     TypeName exp_type ( operand->typeCheck(gamma, fun, errors) );
-    if (exp_type != TypeName("int")) {
-        errors.push_back("[NEG] in function " + fun->name + ": negating type " + exp_type.type_name + " instead of int");
+    if (exp_type != TypeName(types().integer())) {
+        errors.push_back("[NEG] in function " + fun->name.str() + ": negating type " + exp_type.str() + " instead of int");
     }
-    return TypeName("int");
+    return TypeName(types().integer());
 };
 
 TypeName BinaryOp::typeCheck(Gamma& gamma, const Function* fun, Errors& errors, Exp* left, Exp* right) const {
     TypeName left_type ( left->typeCheck(gamma, fun, errors) );
     TypeName right_type ( right->typeCheck(gamma, fun, errors) );
-    if ( left_type != TypeName("int") ) {
-        errors.push_back("[BINOP-REST] in function " + fun->name + ": operand has type " + left_type.type_name + " instead of int");
+    if ( left_type != TypeName(types().integer()) ) {
+        errors.push_back("[BINOP-REST] in function " + fun->name.str() + ": operand has type " + left_type.str() + " instead of int");
     }
-    if ( right_type != TypeName("int") ) {
-        errors.push_back("[BINOP-REST] in function " + fun->name + ": operand has type " + right_type.type_name + " instead of int");
+    if ( right_type != TypeName(types().integer()) ) {
+        errors.push_back("[BINOP-REST] in function " + fun->name.str() + ": operand has type " + right_type.str() + " instead of int");
     }
-    return TypeName("int");
+    return TypeName(types().integer());
 }
 
 TypeName Equal::typeCheck(Gamma& gamma, const Function* fun, Errors& errors, Exp* left, Exp* right) const {
     TypeName left_type ( left->typeCheck(gamma, fun, errors) );
     TypeName right_type ( right->typeCheck(gamma, fun, errors) );
-    if (left_type != TypeName("int") && left_type.type_name[0] != '&') {
-        errors.push_back("[BINOP-EQ] in function " + fun->name + ": operand has non-primitive type " + left_type.type_name);
+    if (left_type != TypeName(types().integer()) && !left_type.type->isPtr()) {
+        errors.push_back("[BINOP-EQ] in function " + fun->name.str() + ": operand has non-primitive type " + left_type.str());
     }
-    if (right_type != TypeName("int") && right_type.type_name[0] != '&') {
-        errors.push_back("[BINOP-EQ] in function " + fun->name + ": operand has non-primitive type " + right_type.type_name);
+    if (right_type != TypeName(types().integer()) && !right_type.type->isPtr()) {
+        errors.push_back("[BINOP-EQ] in function " + fun->name.str() + ": operand has non-primitive type " + right_type.str());
     }
     if (left_type != right_type) {
-        errors.push_back("[BINOP-EQ] in function " + fun->name + ": operands with different types: " + left_type.type_name + " vs " + right_type.type_name);
+        errors.push_back("[BINOP-EQ] in function " + fun->name.str() + ": operands with different types: " + left_type.str() + " vs " + right_type.str());
     }
-    return TypeName("int");
+    return TypeName(types().integer());
 }
 
 TypeName const arrayAccess_TC(Gamma& gamma, const Function* fun, Errors& errors, variant<Exp*, Lval*> ptr, Exp* index) {
     TypeName ptr_type = visit([&ptr_type, &gamma, &fun, &errors](auto* arg) { return arg->typeCheck(gamma, fun, errors); }, ptr);
     TypeName index_type = index->typeCheck(gamma, fun, errors);
-    if (index_type != TypeName("int")) {
-        errors.push_back("[ARRAY] in function " + fun->name + ": array index is type " + index_type.type_name + " instead of int");
+    if (index_type != TypeName(types().integer())) {
+        errors.push_back("[ARRAY] in function " + fun->name.str() + ": array index is type " + index_type.str() + " instead of int");
     }
-    if (ptr_type.type_name == "_") { return TypeName("_"); }
-    if (ptr_type.type_name != "_" && ptr_type.type_name[0] != '&') { //don't have to worry about dereferencing nil
-        errors.push_back("[ARRAY] in function " + fun->name + ": dereferencing non-pointer type " + ptr_type.type_name);
-        return TypeName("_");
+    if (ptr_type.type->isAny()) { return TypeName(types().any()); }
+    if (!ptr_type.type->isPtr()) { //don't have to worry about dereferencing nil
+        errors.push_back("[ARRAY] in function " + fun->name.str() + ": dereferencing non-pointer type " + ptr_type.str());
+        return TypeName(types().any());
     }
-    return TypeName( ptr_type.type_name.substr(1) );
+    return TypeName(ptr_type.type->ref);
 }
-TypeName ExpArrayAccess::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
+TypeName ExpArrayAccess::check(Gamma& gamma, const Function* fun, Errors& errors) const {
     return arrayAccess_TC(gamma, fun, errors, ptr, index);
 }
-TypeName LvalArrayAccess::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
+TypeName LvalArrayAccess::check(Gamma& gamma, const Function* fun, Errors& errors) const {
     return arrayAccess_TC(gamma, fun, errors, ptr, index);
 }
 
-TypeName const fieldAccess_TC(Gamma& gamma, const Function* fun, Errors& errors, variant<Exp*, Lval*> ptr, string field) {
+TypeName const fieldAccess_TC(Gamma& gamma, const Function* fun, Errors& errors, variant<Exp*, Lval*> ptr, SymbolId field) {
     TypeName ptr_type = visit([&ptr_type, &gamma, &fun, &errors](auto* arg) { return arg->typeCheck(gamma, fun, errors); }, ptr);
-    if (ptr_type.type_name == "_") { return TypeName("_"); } //errors won't happpen given Any struct
+    if (ptr_type.type->isAny()) { return TypeName(types().any()); } //errors won't happpen given Any struct
     
-    string struct_type = ptr_type.type_name.substr(1);    
+    const CanonType* struct_type = ptr_type.type->ref;
     if ( !ptr_type.isValidFieldAcesss()) { //if accessing something other than a struct type
-        errors.push_back("[FIELD] in function " + fun->name + ": accessing field of incorrect type " + ptr_type.type_name);
-        return TypeName("_"); //all three errors are mutually exclusive
-    }
-    if (delta.find(struct_type) == delta.end() ) {  // If the iterator points to the end of the map, the key doesn't exist
-        errors.push_back("[FIELD] in function " + fun->name + ": accessing field of non-existent struct type " + struct_type);
-        return TypeName("_");
-    }
-    if (delta[struct_type].find(field) == delta[struct_type].end()) {
-        errors.push_back("[FIELD] in function " + fun->name + ": accessing non-existent field " + field + " of struct type " + struct_type);
-        return TypeName("_");
+        errors.push_back("[FIELD] in function " + fun->name.str() + ": accessing field of incorrect type " + ptr_type.str());
+        return TypeName(types().any()); //all three errors are mutually exclusive
+    }
+    SymbolId struct_id = struct_type->name; // _ for nil, which names no struct
+    auto fields = delta.find(struct_id);
+    if (fields == delta.end() ) {  // If the iterator points to the end of the map, the key doesn't exist
+        errors.push_back("[FIELD] in function " + fun->name.str() + ": accessing field of non-existent struct type " + struct_type->text);
+        return TypeName(types().any());
+    }
+    Type* const* field_type = fields->second.find(field);
+    if (!field_type) {
+        errors.push_back("[FIELD] in function " + fun->name.str() + ": accessing non-existent field " + field.str() + " of struct type " + struct_type->text);
+        return TypeName(types().any());
     }    
-    return TypeName(delta[struct_type][field]->typeName().type_name, struct_type, field);
+    return TypeName((*field_type)->canon, struct_id, field);
 }
-TypeName ExpFieldAccess::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
+TypeName ExpFieldAccess::check(Gamma& gamma, const Function* fun, Errors& errors) const {
     TypeName temp = fieldAccess_TC(gamma, fun, errors, ptr, field);
     return temp;
 }
-TypeName LvalFieldAccess::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
+TypeName LvalFieldAccess::check(Gamma& gamma, const Function* fun, Errors& errors) const {
     TypeName temp = fieldAccess_TC(gamma, fun, errors, ptr, field);
     return temp;
 }
 
 pair<TypeName, bool> call_TC(Gamma& gamma, const Function* fun, Errors& errors, variant<Exp*, Lval*> callee, vector<Exp*> args) {    
     TypeName callee_type = visit([&callee_type, &gamma, &fun, &errors](auto* arg) { return arg->typeCheck(gamma, fun, errors); }, callee);
-    bool isFieldAccess = visit([](auto* arg) { return arg->isFieldAccess(); }, callee);
-    string callee_name = visit([](auto* arg) { return arg->getName(); }, callee); //field name for field, function for others
+    // A call through a field, as an expression or a statement, takes its type from the struct's fields
+    bool isFieldAccess = holds_alternative<Exp*>(callee) ? isa<ExpFieldAccess>(get<Exp*>(callee)) : isa<LvalFieldAccess>(get<Lval*>(callee));
+    SymbolId callee_name = visit([](auto* arg) { return arg->getName(); }, callee); //field name for field, function for others
+    // Arguments from the first one not checked against a parameter on are still
+    // checked, for the types lowering reads, but their errors were never reported
+    auto checkRest = [&gamma, &fun, &args](size_t from) {
+        Errors dropped;
+        for (size_t i = from; i < args.size(); i++) { args[i]->typeCheck(gamma, fun, dropped); }
+    };
     
-    if (callee_name == "_") { return pair<TypeName, bool>(TypeName("_"), true); } //no need to continue if Any
+    if (callee_name == SymbolTable::Underscore) { checkRest(0); return pair<TypeName, bool>(TypeName(types().any()), true); } //no need to continue if Any
     bool success = true;
     
     string expression_statement = holds_alternative<Exp*>(callee) ? "[ECALL" : "[SCALL";
-    if (callee_name == "main") { //If so, can't be an extern call
-        errors.push_back(expression_statement+"-INTERNAL] in function " + fun->name + ": calling main");
+    if (callee_name == SymbolTable::Main) { //If so, can't be an extern call
+        errors.push_back(expression_statement+"-INTERNAL] in function " + fun->name.str() + ": calling main");
         success = false;
     }
-    if (callee_type.type_name == "_") { return pair<TypeName, bool>(TypeName("_"), true); }
+    if (callee_type.type->isAny()) { checkRest(0); return pair<TypeName, bool>(TypeName(types().any()), true); }
     if (!callee_type.isFunction()) { //main can be a parameter, so should check if bad type
-        errors.push_back(expression_statement+"-*] in function " + fun->name + ": calling non-function type " + callee_type.type_name);
-        return pair<TypeName, bool>(TypeName("_"), false);
+        errors.push_back(expression_statement+"-*] in function " + fun->name.str() + ": calling non-function type " + callee_type.str());
+        checkRest(0);
+        return pair<TypeName, bool>(TypeName(types().any()), false);
     }
-    if (callee_name == "main" && functions_map.find("main") == functions_map.end()) { //if main not defined as a function, return
-            return pair<TypeName, bool>(TypeName("_"), false);
+    if (callee_name == SymbolTable::Main && functions_map.find(SymbolTable::Main) == functions_map.end()) { //if main not defined as a function, return
+            checkRest(0);
+            return pair<TypeName, bool>(TypeName(types().any()), false);
     }
-    if (callee_type.type_name == "_") { return pair<TypeName, bool>(TypeName("_"), true); } //callee is just any, just return undefined error which typeCheck already added (and possibly main error)
-    
-    ParamsReturnVal prv;
+    if (callee_type.type->isAny()) { checkRest(0); return pair<TypeName, bool>(TypeName(types().any()), true); } //callee is just any, just return undefined error which typeCheck already added (and possibly main error)
     
-    if ( isFieldAccess ) { //can assume struct name exists, not field
-        string struct_name = callee_type.struct_name;
-        string field_name = callee_type.field_name;
-        prv = struct_functions_map[struct_name][field_name];
-    } else { //can assume it exists since we already returned for values not in gamma
-        prv = functions_map[callee_name]; 
+    // The signature comes from the maps where they hold the callee, and from the
+    // callee's own type where they don't; a miss is never an exception, as
+    // checking runs on the pool's workers
+    const ParamsReturnVal* prv = nullptr;
+    if ( isFieldAccess ) {
+        auto fields = struct_functions_map.find(callee_type.struct_name);
+        if (fields != struct_functions_map.end()) {
+            auto field = fields->second.find(callee_type.field_name);
+            if (field != fields->second.end()) prv = &field->second;
+        }
+    } else {
+        auto found = functions_map.find(callee_name); // find, not [], so that checking never writes to the shared maps
+        if (found != functions_map.end()) prv = &found->second;
+    }
+    const CanonType* signature = callee_type.type->isPtr() ? callee_type.type->ref : callee_type.type;
+    vector<const CanonType*> params = signature->params;
+    const CanonType* ret = signature->ref;
+    if (prv) {
+        params.clear();
+        for (Type* prm: prv->first) params.push_back(prm->canon);
+        ret = prv->second->canon;
     }
     
-    string internal_external = ( callee_type.type_name[0] == '&' ) ? "-INTERNAL]" : "-EXTERN]";
+    string internal_external = ( callee_type.type->isPtr() ) ? "-INTERNAL]" : "-EXTERN]";
     string error_type = expression_statement + internal_external;
-    if (expression_statement != "[SCALL" && prv.second->typeName().type_name == "_") { // empty return type
-        errors.push_back(error_type + " in function " + fun->name + ": calling a function with no return value");
+    if (expression_statement != "[SCALL" && ret->isAny()) { // empty return type
+        errors.push_back(error_type + " in function " + fun->name.str() + ": calling a function with no return value");
         success = false;
     }
-    if (prv.first.size() != args.size()) {
-        errors.push_back(error_type + " in function " + fun->name + 
-        ": call number of arguments (" + to_string(args.size()) + ") and parameters (" + to_string(prv.first.size()) + ") don't match");
+    if (params.size() != args.size()) {
+        errors.push_back(error_type + " in function " + fun->name.str() + 
+        ": call number of arguments (" + to_string(args.size()) + ") and parameters (" + to_string(params.size()) + ") don't match");
         success = false;
     }
-    unsigned int min = (prv.first.size() < args.size()) ? prv.first.size() : args.size();
+    unsigned int min = (params.size() < args.size()) ? params.size() : args.size();
     for (unsigned int i = 0; i < min; i++) {
-        TypeName param_type = prv.first[i]->typeName();
+        TypeName param_type(params[i]);
         TypeName arg_type = args[i]->typeCheck(gamma, fun, errors);
         if (param_type != arg_type) {
-            errors.push_back(error_type + " in function " + fun->name + ": call argument has type " + arg_type.type_name 
-                + " but parameter has type " + param_type.type_name);
+            errors.push_back(error_type + " in function " + fun->name.str() + ": call argument has type " + arg_type.str() 
+                + " but parameter has type " + param_type.str());
             success = false;
         }
     }
-    pair<TypeName, bool> temp(prv.second->typeName(), success);
-    return pair<TypeName, bool>(prv.second->typeName(), success);
+    checkRest(min);
+    return pair<TypeName, bool>(TypeName(ret), success);
 }
 
-TypeName ExpCall::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
+TypeName ExpCall::check(Gamma& gamma, const Function* fun, Errors& errors) const {
     return call_TC(gamma, fun, errors, callee, args).first;
 }
 
@@ -1065,22 +1107,22 @@ bool StmtCall::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& e
 }
 
 bool Return::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const {
-    bool is_return_type_any = fun->rettyp->isAny();
-    bool is_return_exp_any = exp->isAny();
+    bool is_return_type_any = isa<Any>(fun->rettyp);
+    bool is_return_exp_any = isa<AnyExp>(exp);
     TypeName return_type = fun->rettyp->typeName();
     TypeName exp_type = exp->typeCheck(gamma, fun, errors); //store typename given, typeCheck will replace undefined variables with Any
-    if ( !is_return_exp_any && exp_type.type_name == "_") { 
+    if ( !is_return_exp_any && exp_type.type->isAny()) { 
         if ( is_return_type_any ) {
-            errors.push_back("[RETURN-1] in function " + fun->name + ": should return nothing but returning " + exp_type.type_name);
+            errors.push_back("[RETURN-1] in function " + fun->name.str() + ": should return nothing but returning " + exp_type.str());
         } else { return true; }
     } //If exp was made to be Any in typeCheck
-    if ( exp_type.type_name != return_type.type_name) { //If not equal, then at least one of the types not _ and they are different
+    if ( exp_type.type != return_type.type) { //If not equal, then at least one of the types not _ and they are different
         if ( is_return_type_any && !is_return_exp_any ) { //If it wasnt Any before
-            errors.push_back("[RETURN-1] in function " + fun->name + ": should return nothing but returning " + exp_type.type_name);
-        } else if ( return_type.type_name != "_" && exp_type.type_name == "_") { //If it was Any before
-            errors.push_back("[RETURN-2] in function " + fun->name + ": should return " + return_type.type_name + " but returning nothing");
+            errors.push_back("[RETURN-1] in function " + fun->name.str() + ": should return nothing but returning " + exp_type.str());
+        } else if ( !return_type.type->isAny() && exp_type.type->isAny()) { //If it was Any before
+            errors.push_back("[RETURN-2] in function " + fun->name.str() + ": should return " + return_type.str() + " but returning nothing");
         } else if (exp_type != return_type) {
-            errors.push_back("[RETURN-2] in function " + fun->name + ": should return " + return_type.type_name + " but returning " + exp_type.type_name);
+            errors.push_back("[RETURN-2] in function " + fun->name.str() + ": should return " + return_type.str() + " but returning " + exp_type.str());
         }
         return false;
     }
@@ -1090,25 +1132,25 @@ bool Return::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& err
 TypeName New::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) const {
     TypeName amount_type = amount->typeCheck(gamma, fun, errors);
     TypeName type_typename = type->typeName();
-    if((amount_type.type_name != "int") && (amount_type.type_name != "_")) {
-        errors.push_back("[ASSIGN-NEW] in function " + fun->name + ": allocation amount is type " + amount_type.type_name + " instead of int");
+    if(!amount_type.type->isInt() && !amount_type.type->isAny()) {
+        errors.push_back("[ASSIGN-NEW] in function " + fun->name.str() + ": allocation amount is type " + amount_type.str() + " instead of int");
     }
     if(type_typename.isNonPointerFunction()) {
-        errors.push_back("[ASSIGN-NEW] in function " + fun->name + ": allocating function type " + type_typename.type_name);
+        errors.push_back("[ASSIGN-NEW] in function " + fun->name.str() + ": allocating function type " + type_typename.str());
     }
-    return TypeName("new " + type_typename.type_name);
+    return type_typename; // Assign tells an allocation from its rhs
 }
 
 bool Break::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const {
     if(!loop){
-        errors.push_back("[BREAK] in function " + fun->name + ": break outside of loop");
+        errors.push_back("[BREAK] in function " + fun->name.str() + ": break outside of loop");
         return false;
     } else{ return true; }
 }
 
 bool Continue::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const {
     if(!loop){
-        errors.push_back("[CONTINUE] in function " + fun->name + ": continue outside of loop");
+        errors.push_back("[CONTINUE] in function " + fun->name.str() + ": continue outside of loop");
         return false;
     } else { return true; }
 }
@@ -1117,24 +1159,25 @@ bool Assign::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& err
     TypeName lhs_type = lhs->typeCheck(gamma, fun, errors);
     TypeName rhs_type = rhs->typeCheck(gamma, fun, errors);
     bool tf = true;
-    if((rhs_type.type_name == "new _") || lhs_type == rhs_type){ return true;} 
+    bool allocation = isa<New>(rhs); // rhs_type is then the type allocated
+    if(allocation ? (rhs_type.type->isAny() || lhs_type.type->isAny()) : lhs_type == rhs_type){ return true;} 
     else {
-        if(rhs_type.type_name.substr(0,3) != "new") { //not new section
-            if((lhs_type.type_name != rhs_type.type_name)){ //already not any from top if statement
-                errors.push_back("[ASSIGN-EXP] in function " + fun->name + ": assignment lhs has type " + lhs_type.type_name + " but rhs has type " + rhs_type.type_name);
+        if(!allocation) { //not new section
+            if((lhs_type.type != rhs_type.type)){ //already not any from top if statement
+                errors.push_back("[ASSIGN-EXP] in function " + fun->name.str() + ": assignment lhs has type " + lhs_type.str() + " but rhs has type " + rhs_type.str());
                 tf = false;
             }
             if(lhs_type.isNonPointerFunction() || lhs_type.isStruct()) {
-                errors.push_back("[ASSIGN-EXP] in function " + fun->name + ": assignment to struct or function");
+                errors.push_back("[ASSIGN-EXP] in function " + fun->name.str() + ": assignment to struct or function");
                 tf = false;
             }
         } 
-        else if (lhs_type.type_name == rhs_type.type_name.substr(4)) {
-            errors.push_back("[ASSIGN-NEW] in function " + fun->name + ": assignment lhs has type " + lhs_type.type_name + " but we're allocating type " + rhs_type.type_name.substr(4));
+        else if (lhs_type.type == rhs_type.type) {
+            errors.push_back("[ASSIGN-NEW] in function " + fun->name.str() + ": assignment lhs has type " + lhs_type.str() + " but we're allocating type " + rhs_type.str());
             tf = false;
         }
-        else if(lhs_type.type_name != rhs_type.type_name.substr(4) && lhs_type.type_name.substr(1) != rhs_type.type_name.substr(4)){ //not equal types and without pointer not equal
-            errors.push_back("[ASSIGN-NEW] in function " + fun->name + ": assignment lhs has type " + lhs_type.type_name + " but we're allocating type " + rhs_type.type_name.substr(4));
+        else if(!lhs_type.type->isPtr() || lhs_type.type->ref != rhs_type.type){ //not equal types and without pointer not equal
+            errors.push_back("[ASSIGN-NEW] in function " + fun->name.str() + ": assignment lhs has type " + lhs_type.str() + " but we're allocating type " + rhs_type.str());
             tf = false;
          }     
     }
@@ -1144,8 +1187,8 @@ bool Assign::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& err
 bool If::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const {
     TypeName exp_type (guard->typeCheck(gamma, fun, errors));
     bool tf = true;
-    if((exp_type.type_name != "int") && (exp_type.type_name != "_")) {
-        errors.push_back("[IF] in function " + fun->name + ": if guard has type " + exp_type.type_name + " instead of int");
+    if(!exp_type.type->isInt() && !exp_type.type->isAny()) {
+        errors.push_back("[IF] in function " + fun->name.str() + ": if guard has type " + exp_type.str() + " instead of int");
         tf = false;
     }
     for(auto s: tt){ s->typeCheck(gamma, fun, loop, errors); }
@@ -1154,18 +1197,18 @@ bool If::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors)
 }
 bool While::typeCheck(Gamma& gamma, const Function* fun, bool loop, Errors& errors) const {
     TypeName exp_type (guard->typeCheck(gamma, fun, errors));
-    if((exp_type.type_name != "int") && (exp_type.type_name != "_")) {
-        errors.push_back("[WHILE] in function " + fun->name + ": while guard has type " + exp_type.type_name + " instead of int");
+    if(!exp_type.type->isInt() && !exp_type.type->isAny()) {
+        errors.push_back("[WHILE] in function " + fun->name.str() + ": while guard has type " + exp_type.str() + " instead of int");
     }
     for(auto s: body){ s->typeCheck(gamma, fun, true, errors); } 
     return true;
 }
 
-bool global_TC(Gamma& gamma, Errors& errors, string global_name, Type* type) {
+bool global_TC(Gamma& gamma, Errors& errors, SymbolId global_name, Type* type) {
     bool tf = true;
     TypeName global_type = type->typeName();
     if ( global_type.isStruct() || global_type.isNonPointerFunction() ) { 
-        errors.push_back("[GLOBAL] global " + global_name + " has a struct or function type");
+        errors.push_back("[GLOBAL] global " + global_name.str() + " has a struct or function type");
         tf = false; 
     }
     return tf;
@@ -1176,7 +1219,7 @@ bool Struct::typeCheck(Gamma& gamma, Errors& errors) const {
     for (Decl* decl: fields) {
         TypeName field_type = decl->typeName();
         if ( field_type.isStruct() || field_type.isNonPointerFunction() ) { 
-            errors.push_back("[STRUCT] struct " + name + " field " + decl->name + " has a struct or function type");
+            errors.push_back("[STRUCT] struct " + name.str() + " field " + decl->name.str() + " has a struct or function type");
             tf = false; 
         }
     }
@@ -1189,19 +1232,19 @@ bool Function::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) cons
     for (Decl* decl: params) {
         TypeName var_type = decl->typeName();
         if ( var_type.isStruct() || var_type.isNonPointerFunction() ) { 
-            errors.push_back("[FUNCTION] in function " + name + ": variable " + decl->name + " has a struct or function type");
+            errors.push_back("[FUNCTION] in function " + name.str() + ": variable " + decl->name.str() + " has a struct or function type");
             tf = false; 
         }
     }
     for (auto [decl, exp]: locals) {
         TypeName var_type = decl->typeName();
         if ( var_type.isStruct() || var_type.isNonPointerFunction() ) { 
-            errors.push_back("[FUNCTION] in function " + name + ": variable " + decl->name+ " has a struct or function type");
+            errors.push_back("[FUNCTION] in function " + name.str() + ": variable " + decl->name.str()+ " has a struct or function type");
             tf = false; 
         }
         TypeName exp_type = exp->typeCheck(gamma, fun, errors);
         if (var_type != exp_type) {
-            errors.push_back("[FUNCTION] in function " + name + ": variable " + decl->name + " with type " + var_type.type_name + " has initializer of type " + exp_type.type_name);
+            errors.push_back("[FUNCTION] in function " + name.str() + ": variable " + decl->name.str() + " with type " + var_type.str() + " has initializer of type " + exp_type.str());
             tf = false; 
         }
     }
@@ -1211,7 +1254,7 @@ bool Function::typeCheck(Gamma& gamma, const Function* fun, Errors& errors) cons
     return tf;
 }
 
-bool Program::typeCheck(Gamma& gamma, Errors& errors, unordered_map<string, Gamma>& locals_map) const { //input gamma is the initial gamma
+bool Program::typeCheck(Gamma& gamma, Errors& errors, unordered_map<SymbolId, Gamma>& locals_map, unsigned threads) const { //input gamma is the initial gamma
     bool tf = true;
     for (Decl* decl: globals) {
         if (!global_TC(gamma, errors, decl->name, decl->type)) { tf = false; }
@@ -1219,180 +1262,125 @@ bool Program::typeCheck(Gamma& gamma, Errors& errors, unordered_map<string, Gamm
     for (Struct* str: structs) {
         if (!str->typeCheck(gamma, errors)) { tf = false; }
     }
-    for (Function* fun: functions) { //Creating locals map
-        if (!fun->typeCheck(locals_map[fun->name], fun, errors)) { tf = false; }
-    } 
+    // Checking a function only reads the shared maps and writes to its own
+    // scope, so functions are checked in parallel. Each one reports into its own
+    // buffer, and the buffers are appended in program order, so errors reads the
+    // same as when the functions are checked one after another.
+    vector<Errors> function_errors(functions.size());
+    vector<char> function_ok(functions.size());
+    WorkPool(threads).run(functions.size(), [&](size_t i, unsigned) {
+        Function* fun = functions[i];
+        function_ok[i] = fun->typeCheck(locals_map.at(fun->name), fun, function_errors[i]);
+    });
+    for (size_t i = 0; i < functions.size(); i++) {
+        if (!function_ok[i]) { tf = false; }
+        errors.insert(errors.end(), make_move_iterator(function_errors[i].begin()), make_move_iterator(function_errors[i].end()));
+    }
     return tf;
 }
 
 
 //LIR
 
-tuple<unsigned int, string, string> ExpFieldAccess::lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const {
-        auto [eval_var_src, eval_string_src, src_type] = ptr->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        string res = "";
-        string lhs_type = "";
-        if (eval_var_src != 0) {
-            res += eval_string_src;
-            eval_string_src = "_t" + to_string(eval_var_src);
-        }
-        size_t start_pos = src_type.find("Struct(") + 7;
-        string struct_type = src_type.substr(start_pos, src_type.find(')') - start_pos);
-        string field_type = delta[struct_type][field]->toLIRType();
-        tempsToType.push_back("Ptr(" + field_type + ")");
+pair<LIR::Operand, const CanonType*> ExpFieldAccess::lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const {
+        auto [src, src_type] = ptr->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        tempsToType.push_back(types().ptr(type));
         unsigned int fresh_var_fldp = tempsToType.size();
-        lhs_type = field_type;
+        const CanonType* lhs_type = type;
         tempsToType.push_back(lhs_type);
         unsigned int fresh_var_lhs = tempsToType.size();
-        res += "    Gfp(_t" + to_string(fresh_var_fldp) + ", " + eval_string_src + ", " + field + ")\n";
-        res += "    Load(_t" + to_string(fresh_var_lhs) + ", _t" + to_string(fresh_var_fldp) + ")\n";
-        return make_tuple(fresh_var_lhs, res, lhs_type);
+        code.emit(LIR::Gfp(LIR::temp(fresh_var_fldp), src, field));
+        code.emit(LIR::Load(LIR::temp(fresh_var_lhs), LIR::temp(fresh_var_fldp)));
+        return make_pair(LIR::temp(fresh_var_lhs), lhs_type);
 }
 
-tuple<unsigned int, string, string> LvalFieldAccess::lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const {
-    auto [eval_var_src, eval_string_src, src_type] = le(tempsToType, numLabels, gamma, fun, ptr, extern_map, function_map);
-    string res = "";
-    string lhs_type = "";
-    if (eval_var_src != 0) {
-        res += eval_string_src;
-        eval_string_src = "_t" + to_string(eval_var_src);
-    }
-    size_t start_pos = src_type.find("Struct(") + 7;
-    string struct_type = src_type.substr(start_pos, src_type.find(')') - start_pos);
-    string field_type = delta[struct_type][field]->toLIRType();
-    lhs_type = "Ptr(" + field_type + ")";
+pair<LIR::Operand, const CanonType*> LvalFieldAccess::lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const {
+    auto [src, src_type] = le(code, tempsToType, numLabels, gamma, fun, ptr, extern_map, function_names);
+    const CanonType* lhs_type = types().ptr(type);
     tempsToType.push_back(lhs_type);
     unsigned int fresh_var_lhs = tempsToType.size();
-    res += "    Gfp(_t" + to_string(fresh_var_lhs) + ", " + eval_string_src + ", " + field + ")\n";
-    return make_tuple(fresh_var_lhs, res, lhs_type);
+    code.emit(LIR::Gfp(LIR::temp(fresh_var_lhs), src, field));
+    return make_pair(LIR::temp(fresh_var_lhs), lhs_type);
 }
-tuple<unsigned int, string, string> ExpCall::lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, map<string, string>& extern_map, map<string, string>& function_map) const {
-    string res = "";
-    string lhs_type = "";
-    string aops = "[";
-    for (unsigned int i = 0; i < args.size(); i++) {
-        auto [eval_var_src, eval_string_src, src_type] = args[i]->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        if (eval_var_src != 0) {
-            res += eval_string_src;
-            eval_string_src = "_t" + to_string(eval_var_src);
-        }
-        aops += eval_string_src;
-        if (i != args.size() - 1) { aops += ", "; }
+pair<LIR::Operand, const CanonType*> ExpCall::lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const {
+    vector<LIR::Operand> aops;
+    for (Exp* arg: args) {
+        auto [value, arg_type] = arg->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        aops.push_back(value);
     }
-    aops += "]";
 
-    ParamsReturnVal prv;
-    string callee_name;
+    SymbolId callee_id;
     bool direct = true;
     bool isExtern = false;
     bool isFunction = false;
 
-    auto [eval_var_lhs, eval_string_lhs, _] = callee->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-    if (eval_var_lhs != 0) {
-        res += eval_string_lhs;
-        eval_string_lhs = "_t" + to_string(eval_var_lhs);
-    }
-    if ( callee->isFieldAccess() ) { //can assume struct name exists, not field
-        Errors errors;
-        string struct_name = callee->getPtr()->typeCheck(gamma, fun, errors).type_name.substr(1);
-        string field_name = callee->getName();
-        prv = struct_functions_map[struct_name][field_name];
-        callee_name = eval_string_lhs; //id is the most recent fresh variable made
+    auto [callee_op, _] = callee->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+    if ( isa<ExpFieldAccess>(callee) ) { //can assume struct name exists, not field
+        direct = false; // called through the field's value, the most recent fresh variable made
     } else { //can assume it exists since we already returned for values not in gamma
-        callee_name = callee->getName();
-        // cout << "Callee name: " << callee_name << "\n";
-        prv = functions_map[callee_name]; 
-        // cout << "Callee type: " << callee_type << "\n";
-        if (!callee->isId()) {
+        callee_id = callee->getName();
+        if (!isa<ExpId>(callee)) {
             direct = false;
         } else {
-            for (Decl* param: fun->params) { if (param->name == callee_name) { direct = false; } }
-            for (auto [local, _]: fun->locals) { if (local->name == callee_name) { direct = false; } }
+            for (Decl* param: fun->params) { if (param->name == callee_id) { direct = false; } }
+            for (auto [local, _]: fun->locals) { if (local->name == callee_id) { direct = false; } }
         }
-        for (auto& pair: extern_map) { if (pair.first == callee_name) isExtern = true; }
-        for (auto& pair: function_map) { if (pair.first == callee_name) isFunction = true; }
-        // cout << "For function call " << callee_name << " is it direct? " << direct << "\n";
+        isExtern = extern_map.count(callee_id) != 0;
+        isFunction = function_names.count(callee_id) != 0;
+        // cout << "For function call " << callee_id << " is it direct? " << direct << "\n";
     }
-    lhs_type = prv.second->toLIRType();
+    const CanonType* lhs_type = type; // the callee's return type
     tempsToType.push_back(lhs_type);
     unsigned int fresh_var_lhs = tempsToType.size();
 
     if (direct && isExtern) {
-        res += "    CallExt(_t" + to_string(fresh_var_lhs) + ", " + callee_name + ", " + aops + ")\n";
+        code.emit(LIR::CallExt(LIR::temp(fresh_var_lhs), LIR::var(callee_id), move(aops)));
     } else {
         unsigned int NEXT = numLabels + 1;
         numLabels++;
         if (direct && isFunction) {
-            res += "    CallDirect(_t" + to_string(fresh_var_lhs) + ", " + callee_name + ", " + aops + ", lbl" + to_string(NEXT) + ")\n";
+            code.emit(LIR::CallDirect(LIR::temp(fresh_var_lhs), LIR::var(callee_id), move(aops), NEXT));
         } else {
-            res += "    CallIndirect(_t" + to_string(fresh_var_lhs) + ", " + eval_string_lhs + ", " + aops + ", lbl" + to_string(NEXT) + ")\n";
+            code.emit(LIR::CallIndirect(LIR::temp(fresh_var_lhs), callee_op, move(aops), NEXT));
         }
-        res += "\n  lbl" + to_string(NEXT) + ":\n";
+        code.label(NEXT);
     }
-    return make_tuple(fresh_var_lhs, res, lhs_type); 
+    return make_pair(LIR::temp(fresh_var_lhs), lhs_type); 
 }
 
-string StmtCall::lower(vector<string>& tempsToType, unsigned int& numLabels, Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, map<string, string>& extern_map, map<string, string>& function_map) const {
-    string res = "";
-    string aops = "[";
-    for (unsigned int i = 0; i < args.size(); i++) {
-        auto [eval_var_src, eval_string_src, src_type] = args[i]->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        if (eval_var_src != 0) {
-            res += eval_string_src;
-            eval_string_src = "_t" + to_string(eval_var_src);
-        }
-        aops += eval_string_src;
-        if (i != args.size() - 1) { aops += ", "; }
+void StmtCall::lower(LIR::CodeBuilder& code, vector<const CanonType*>& tempsToType, unsigned int& numLabels, const Gamma& gamma, const Function* fun, unsigned int& prevWhileHdr, unsigned int& prevWhileEnd, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names) const {
+    vector<LIR::Operand> aops;
+    for (Exp* arg: args) {
+        auto [value, arg_type] = arg->lower(code, tempsToType, numLabels, gamma, fun, extern_map, function_names);
+        aops.push_back(value);
     }
-    aops += "]";
 
-    string callee_name;
     bool direct = true;
     bool isExtern = false;
     bool isFunction = false;
-    //KEEP
-    if ( callee->isFieldAccess() ) { //can assume struct name exists, not field
-        Errors errors;
-        string struct_name = callee->getPtr()->typeCheck(gamma, fun, errors).type_name.substr(1);
-        string field_name = callee->getName();
-        auto [eval_var_lhs, eval_string_lhs, _] = callee->lower(tempsToType, numLabels, gamma, fun, extern_map, function_map);
-        if (eval_var_lhs != 0) {
-            res += eval_string_lhs;
-            eval_string_lhs = "_t" + to_string(eval_var_lhs);
-        }
-        callee_name = eval_string_lhs; //id is the most recent fresh variable made
-    } else { //can assume it exists since we already returned for values not in gamma
-        callee_name = callee->getName();
-        // cout << "Callee name: " << callee_name << "\n";
-        // cout << "Callee type: " << callee_type << "\n";
-        if (!callee->isId()) {
-            direct = false;
-        } else {
-            for (Decl* param: fun->params) { if (param->name == callee_name) { direct = false; } }
-            for (auto [local, _]: fun->locals) { if (local->name == callee_name) { direct = false; } }
-        }
-        for (auto& pair: extern_map) { if (pair.first == callee_name) isExtern = true; }
-        for (auto& pair: function_map) { if (pair.first == callee_name) isFunction = true; }
-        // cout << "For function call " << callee_name << " is it direct? " << direct << "\n";
+    // A call through a field (or any non-name) is indirect: the callee is loaded by le() below
+    SymbolId callee_id = callee->getName();
+    if (!isa<LvalId>(callee)) {
+        direct = false;
+    } else {
+        for (Decl* param: fun->params) { if (param->name == callee_id) { direct = false; } }
+        for (auto [local, _]: fun->locals) { if (local->name == callee_id) { direct = false; } }
     }
+    isExtern = extern_map.count(callee_id) != 0;
+    isFunction = function_names.count(callee_id) != 0;
 
     if (direct && isExtern) {
-        res += "    CallExt(_, " + callee_name + ", " + aops + ")\n";
+        code.emit(LIR::CallExt(LIR::none(), LIR::var(callee_id), move(aops)));
     } else {
         unsigned int NEXT = numLabels + 1;
         numLabels++;
         if (direct && isFunction) {
-            res += "    CallDirect(_, " + callee_name + ", " + aops + ", lbl" + to_string(NEXT) + ")\n";
+            code.emit(LIR::CallDirect(LIR::none(), LIR::var(callee_id), move(aops), NEXT));
         } else {
-            auto [le_var, le_string, le_type] = callee->le(tempsToType, numLabels, gamma, fun, callee, extern_map, function_map);
-            if (le_var != 0) {
-                res += le_string;
-                le_string = "_t" + to_string(le_var);
-            }
-            res += "    CallIndirect(_, " + le_string + ", " + aops + ", lbl" + to_string(NEXT) + ")\n";
+            auto [callee_op, callee_type] = callee->le(code, tempsToType, numLabels, gamma, fun, callee, extern_map, function_names);
+            code.emit(LIR::CallIndirect(LIR::none(), callee_op, move(aops), NEXT));
         }
-        res += "\n  lbl" + to_string(NEXT) + ":\n";
+        code.label(NEXT);
     }
-    return res;
 }
 #endif
\ No newline at end of file
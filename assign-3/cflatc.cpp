@@ -0,0 +1,157 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <cstdlib>
+#include "../assign-1/source.cpp"
+#include "../assign-1/pull_lexer.cpp"
+#include "grammar.cpp"
+#include "lir_file.cpp"
+#include "maps.cpp"
+using namespace std;
+
+// cflatc: the whole pipeline in one process. Lexes, parses, typechecks and lowers a
+// cflat source file in memory, with no token file or JSON between the stages.
+//   cflatc [--emit=tokens|ast|errors|lir|lirb] [--time] [-j threads] <file>
+// --emit stops after the named stage and prints its result (default lir):
+//   tokens - one token per line, as `lex` prints them
+//   ast    - the parsed Program
+//   errors - the sorted type errors, as `parse` prints them, except where parse's
+//            string tests misread a type (it takes a struct named intx for int)
+//   lir    - the lowered program, as `lower` prints it
+//   lirb   - the lowered program in the binary LIR format (see lir_file.cpp),
+//            which `lirdump` prints back as text
+// A program with type errors isn't lowered: for lir and lirb the errors go to
+// stderr and cflatc exits with 1.
+// --time prints each stage's wall time to stderr.
+// -j type checks and lowers the functions on that many threads; the output is the
+// same either way.
+
+enum class Stage { Tokens, Ast, Errors, Lir, LirBinary };
+
+struct StageTimer {
+    using Clock = chrono::steady_clock;
+    vector<pair<const char*, double>> times; // stage name to milliseconds
+    Clock::time_point start = Clock::now();
+
+    void lap(const char* stage) {
+        Clock::time_point now = Clock::now();
+        times.emplace_back(stage, chrono::duration<double, milli>(now - start).count());
+        start = now;
+    }
+    void report(ostream& os) const {
+        double total = 0;
+        for (const auto& [stage, ms]: times) {
+            os << left << setw(8) << stage << right << fixed << setprecision(3) << setw(12) << ms << " ms\n";
+            total += ms;
+        }
+        os << left << setw(8) << "total" << right << fixed << setprecision(3) << setw(12) << total << " ms\n";
+    }
+};
+
+// Runs the pipeline up to `emit`, printing that stage's output to stdout.
+// Returns the process exit status.
+int compile(const char* path, Stage emit, unsigned threads, StageTimer& timer) {
+    unique_ptr<SourceFile> source;
+    try {
+        source = make_unique<SourceFile>(path);
+    }
+    catch(const exception& e) {
+        cerr << "Invalid file\n";
+        return 1;
+    }
+    timer.lap("read");
+
+    // The grammar pulls tokens from the lexer as it goes, so lexing is timed as part
+    // of parsing and only PullLexer::Lookahead tokens are ever held. Lexemes are
+    // views into the mapped source, which outlives every later stage.
+    PullLexer lexer(source->view());
+    if (emit == Stage::Tokens) {
+        string out;
+        for (Token t = lexer.next(); t.kind != TokenKind::End; t = lexer.next()) appendTokenText(out, t);
+        timer.lap("lex");
+        cout << out;
+        timer.lap("emit");
+        return 0;
+    }
+
+    Grammar g;
+    g.tokens = TokenCursor(lexer);
+    Program* prog;
+    try {
+        prog = g.program(0);
+    } catch (fail& f) {
+        cout << "parse error at token " << f.get() << "\n";
+        return 1;
+    }
+    timer.lap("parse");
+    if (emit == Stage::Ast) {
+        cout << *prog << "\n";
+        timer.lap("emit");
+        return 0;
+    }
+
+    initializeMaps(prog);
+    prog->typeCheck(globals_map, errors_map, locals_map, threads);
+    sort(errors_map.begin(), errors_map.end());
+    timer.lap("check");
+    if (emit == Stage::Errors) {
+        for (const auto& error : errors_map) {
+            cout << error << "\n";
+        }
+        timer.lap("emit");
+        return 0;
+    }
+    // Lowering assumes every name is in scope, so a program with type errors is
+    // reported and not lowered
+    if (!errors_map.empty()) {
+        for (const auto& error : errors_map) {
+            cerr << error << "\n";
+        }
+        return 1;
+    }
+
+    LIR::Program program(prog, locals_map, threads);
+    timer.lap("lower");
+    if (emit == Stage::LirBinary) {
+        Writer out(stdout);
+        LirFileWriter(program).write(out);
+    }
+    else program.print();
+    timer.lap("emit");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Stage emit = Stage::Lir;
+    bool time = false;
+    unsigned threads = 1;
+    const char* path = nullptr;
+    bool usage = false;
+    for (int i = 1; i < argc; i++) {
+        string_view arg = argv[i];
+        if (arg == "--emit=tokens") emit = Stage::Tokens;
+        else if (arg == "--emit=ast") emit = Stage::Ast;
+        else if (arg == "--emit=errors") emit = Stage::Errors;
+        else if (arg == "--emit=lir") emit = Stage::Lir;
+        else if (arg == "--emit=lirb") emit = Stage::LirBinary;
+        else if (arg == "--time") time = true;
+        else if (arg == "-j" && i + 1 < argc) threads = static_cast<unsigned>(max(1, atoi(argv[++i])));
+        else if (!path && (arg == "-" || arg[0] != '-')) path = argv[i];
+        else usage = true;
+    }
+    if (usage || !path) {
+        cerr << "Usage: cflatc [--emit=tokens|ast|errors|lir|lirb] [--time] [-j threads] <file>\n";
+        return 1;
+    }
+    ios::sync_with_stdio(false);
+    StageTimer timer;
+    int status = compile(path, emit, threads, timer);
+    cout.flush();
+    if (time) timer.report(cerr);
+    return status;
+}
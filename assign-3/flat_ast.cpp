@@ -0,0 +1,394 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ast.cpp"
+using namespace std;
+
+#ifndef FLAT_AST_CPP
+#define FLAT_AST_CPP
+
+// A flat copy of an AST::Program. Nodes are rows of one table per syntactic
+// category, children are 32-bit row indices instead of pointers, identifiers are
+// their SymbolIds, and every list (parameters,
+// arguments, statements, ...) is a run in one shared buffer. A traversal then
+// reads a few dense arrays front to back instead of chasing nodes scattered
+// over the heap.
+//
+// Node rows: the operands a, b, c of a node mean, depending on its kind,
+//   types  Int, Any          -
+//          StructType        a: name
+//          Ptr               a: referenced type
+//          Fn                a: return type     b: list of parameter types
+//   exps   Num               a: value (bits of the int32)
+//          ExpId             a: name
+//          Nil, AnyExp       -
+//          UnOp              a: Op              b: operand
+//          BinOp             a: Op              b: left exp        c: right exp
+//          ExpArrayAccess    a: pointer exp     b: index exp
+//          ExpFieldAccess    a: pointer exp     b: field name
+//          ExpCall           a: callee exp      b: list of argument exps
+//   lvals  LvalId            a: name
+//          LvalDeref         a: lval
+//          LvalArrayAccess   a: pointer lval    b: index exp
+//          LvalFieldAccess   a: pointer lval    b: field name
+//   rhss   RhsExp            a: exp
+//          New               a: type            b: amount exp
+//   stmts  Break, Continue   -
+//          Return            a: exp (AnyExp if there is none)
+//          Assign            a: lval            b: rhs
+//          StmtCall          a: callee lval     b: list of argument exps
+//          If                a: guard exp       b: list of then stmts   c: list of else stmts
+//          While             a: guard exp       b: list of body stmts
+// Unused operands are None.
+
+namespace Flat {
+
+using Index = uint32_t;
+constexpr Index None = UINT32_MAX;
+
+enum class Op : uint8_t { Neg, Deref, Add, Sub, Mul, Div, Equal, NotEq, Lt, Lte, Gt, Gte };
+
+// The entries of a list: a view into Program::lists
+struct Span {
+    const Index* first;
+    Index count;
+    const Index* begin() const { return first; }
+    const Index* end() const { return first + count; }
+    Index size() const { return count; }
+    Index operator[](Index i) const { return first[i]; }
+};
+
+// The nodes of one category, one column per field
+struct Table {
+    vector<AST::Kind> kind;
+    vector<Index> a, b, c;
+
+    Index add(AST::Kind k, Index x = None, Index y = None, Index z = None) {
+        kind.push_back(k);
+        a.push_back(x);
+        b.push_back(y);
+        c.push_back(z);
+        return static_cast<Index>(kind.size() - 1);
+    }
+    size_t size() const { return kind.size(); }
+    size_t bytes() const { return kind.capacity() * sizeof(AST::Kind) + (a.capacity() + b.capacity() + c.capacity()) * sizeof(Index); }
+};
+
+struct Decls {
+    vector<Index> name, type;
+    size_t bytes() const { return (name.capacity() + type.capacity()) * sizeof(Index); }
+};
+struct Structs {
+    vector<Index> name, fields; // fields: list of decls
+    size_t bytes() const { return (name.capacity() + fields.capacity()) * sizeof(Index); }
+};
+// locals and inits are parallel lists: inits[i] initializes locals[i] (AnyExp if it isn't)
+struct Functions {
+    vector<Index> name, params, rettyp, locals, inits, stmts;
+    size_t bytes() const {
+        return (name.capacity() + params.capacity() + rettyp.capacity() + locals.capacity() + inits.capacity() + stmts.capacity()) * sizeof(Index);
+    }
+};
+
+struct Program {
+    Table types, exps, lvals, rhss, stmts;
+    Decls decls;
+    Structs structs;
+    Functions functions;
+    vector<Index> lists; // each list is its length followed by its entries
+    Index globals = None, structDefs = None, externs = None, functionDefs = None; // lists of decls, structs, decls, functions
+
+    Span list(Index handle) const { return Span{ lists.data() + handle + 1, lists[handle] }; }
+    const string& name(Index i) const { return SymbolId{ i }.str(); }
+
+    size_t bytes() const {
+        size_t n = lists.capacity() * sizeof(Index);
+        return n + types.bytes() + exps.bytes() + lvals.bytes() + rhss.bytes() + stmts.bytes() + decls.bytes() + structs.bytes() + functions.bytes();
+    }
+
+    // Pre-order walks. The visitor gets called with the index of each node it
+    // reaches: type(i), exp(i), lval(i), rhs(i), stmt(i), decl(i), structDef(i),
+    // function(i). Locals are visited as decl then init, like AST::Function.
+    template<class V> void walkType(Index t, V& v) const {
+        v.type(t);
+        switch (types.kind[t]) {
+            case AST::Kind::Ptr: walkType(types.a[t], v); break;
+            case AST::Kind::Fn:
+                for (Index p: list(types.b[t])) walkType(p, v);
+                walkType(types.a[t], v);
+                break;
+            default: break;
+        }
+    }
+    template<class V> void walkExp(Index e, V& v) const {
+        v.exp(e);
+        switch (exps.kind[e]) {
+            case AST::Kind::UnOp: walkExp(exps.b[e], v); break;
+            case AST::Kind::BinOp: walkExp(exps.b[e], v); walkExp(exps.c[e], v); break;
+            case AST::Kind::ExpArrayAccess: walkExp(exps.a[e], v); walkExp(exps.b[e], v); break;
+            case AST::Kind::ExpFieldAccess: walkExp(exps.a[e], v); break;
+            case AST::Kind::ExpCall:
+                walkExp(exps.a[e], v);
+                for (Index arg: list(exps.b[e])) walkExp(arg, v);
+                break;
+            default: break;
+        }
+    }
+    template<class V> void walkLval(Index l, V& v) const {
+        v.lval(l);
+        switch (lvals.kind[l]) {
+            case AST::Kind::LvalDeref: walkLval(lvals.a[l], v); break;
+            case AST::Kind::LvalArrayAccess: walkLval(lvals.a[l], v); walkExp(lvals.b[l], v); break;
+            case AST::Kind::LvalFieldAccess: walkLval(lvals.a[l], v); break;
+            default: break;
+        }
+    }
+    template<class V> void walkRhs(Index r, V& v) const {
+        v.rhs(r);
+        if (rhss.kind[r] == AST::Kind::RhsExp) walkExp(rhss.a[r], v);
+        else {
+            walkType(rhss.a[r], v);
+            walkExp(rhss.b[r], v);
+        }
+    }
+    template<class V> void walkStmts(Index handle, V& v) const {
+        for (Index s: list(handle)) walkStmt(s, v);
+    }
+    template<class V> void walkStmt(Index s, V& v) const {
+        v.stmt(s);
+        switch (stmts.kind[s]) {
+            case AST::Kind::Return: walkExp(stmts.a[s], v); break;
+            case AST::Kind::Assign: walkLval(stmts.a[s], v); walkRhs(stmts.b[s], v); break;
+            case AST::Kind::StmtCall:
+                walkLval(stmts.a[s], v);
+                for (Index arg: list(stmts.b[s])) walkExp(arg, v);
+                break;
+            case AST::Kind::If: walkExp(stmts.a[s], v); walkStmts(stmts.b[s], v); walkStmts(stmts.c[s], v); break;
+            case AST::Kind::While: walkExp(stmts.a[s], v); walkStmts(stmts.b[s], v); break;
+            default: break;
+        }
+    }
+    template<class V> void walkDecl(Index d, V& v) const {
+        v.decl(d);
+        walkType(decls.type[d], v);
+    }
+    template<class V> void walkFunction(Index f, V& v) const {
+        v.function(f);
+        for (Index d: list(functions.params[f])) walkDecl(d, v);
+        walkType(functions.rettyp[f], v);
+        Span locals = list(functions.locals[f]), inits = list(functions.inits[f]);
+        for (Index i = 0; i < locals.size(); i++) {
+            walkDecl(locals[i], v);
+            walkExp(inits[i], v);
+        }
+        walkStmts(functions.stmts[f], v);
+    }
+    template<class V> void walk(V& v) const {
+        for (Index d: list(globals)) walkDecl(d, v);
+        for (Index s: list(structDefs)) {
+            v.structDef(s);
+            for (Index d: list(structs.fields[s])) walkDecl(d, v);
+        }
+        for (Index d: list(externs)) walkDecl(d, v);
+        for (Index f: list(functionDefs)) walkFunction(f, v);
+    }
+};
+
+// Builds a Flat::Program from the pointer tree. Lists are written only once
+// their entries are known, so a list's entries are always contiguous even
+// though building them nests.
+struct Flattener {
+    Program out;
+
+    Index name(SymbolId s) { return s.id; }
+    Index list(const vector<Index>& entries) {
+        Index handle = static_cast<Index>(out.lists.size());
+        out.lists.push_back(static_cast<Index>(entries.size()));
+        out.lists.insert(out.lists.end(), entries.begin(), entries.end());
+        return handle;
+    }
+    template<class T, class F> Index list(const vector<T*>& nodes, F&& flatten) {
+        vector<Index> entries;
+        entries.reserve(nodes.size());
+        for (T* n: nodes) entries.push_back(flatten(n));
+        return list(entries);
+    }
+
+    static Op op(const AST::UnaryOp* op) { return AST::isa<AST::Neg>(op) ? Op::Neg : Op::Deref; }
+    static Op op(const AST::BinaryOp* op) {
+        switch (op->kind) {
+            case Kind::Sub: return Op::Sub;
+            case Kind::Mul: return Op::Mul;
+            case Kind::Div: return Op::Div;
+            case Kind::Equal: return Op::Equal;
+            case Kind::NotEq: return Op::NotEq;
+            case Kind::Lt: return Op::Lt;
+            case Kind::Lte: return Op::Lte;
+            case Kind::Gt: return Op::Gt;
+            case Kind::Gte: return Op::Gte;
+            default: return Op::Add;
+        }
+    }
+
+    Index type(const AST::Type* t) {
+        switch (t->kind) {
+            case Kind::StructType: return out.types.add(t->kind, name(cast<StructType>(t)->name));
+            case Kind::Ptr: {
+                Index ref = type(cast<Ptr>(t)->ref);
+                return out.types.add(t->kind, ref);
+            }
+            case Kind::Fn: {
+                const Fn* fn = cast<Fn>(t);
+                Index prms = list(fn->prms, [this](const Type* p) { return type(p); });
+                Index ret = type(fn->ret);
+                return out.types.add(t->kind, ret, prms);
+            }
+            default: return out.types.add(t->kind);
+        }
+    }
+    Index exp(const AST::Exp* e) {
+        switch (e->kind) {
+            case Kind::Num: return out.exps.add(e->kind, static_cast<Index>(cast<Num>(e)->n));
+            case Kind::ExpId: return out.exps.add(e->kind, name(cast<ExpId>(e)->name));
+            case Kind::UnOp: {
+                const UnOp* u = cast<UnOp>(e);
+                Index operand = exp(u->operand);
+                return out.exps.add(e->kind, static_cast<Index>(op(u->op)), operand);
+            }
+            case Kind::BinOp: {
+                const BinOp* b = cast<BinOp>(e);
+                Index left = exp(b->left);
+                Index right = exp(b->right);
+                return out.exps.add(e->kind, static_cast<Index>(op(b->op)), left, right);
+            }
+            case Kind::ExpArrayAccess: {
+                const ExpArrayAccess* a = cast<ExpArrayAccess>(e);
+                Index ptr = exp(a->ptr);
+                Index index = exp(a->index);
+                return out.exps.add(e->kind, ptr, index);
+            }
+            case Kind::ExpFieldAccess: {
+                const ExpFieldAccess* f = cast<ExpFieldAccess>(e);
+                Index ptr = exp(f->ptr);
+                return out.exps.add(e->kind, ptr, name(f->field));
+            }
+            case Kind::ExpCall: {
+                const ExpCall* c = cast<ExpCall>(e);
+                Index callee = exp(c->callee);
+                Index args = list(c->args, [this](const Exp* arg) { return exp(arg); });
+                return out.exps.add(e->kind, callee, args);
+            }
+            default: return out.exps.add(e->kind);
+        }
+    }
+    Index lval(const AST::Lval* l) {
+        switch (l->kind) {
+            case Kind::LvalId: return out.lvals.add(l->kind, name(cast<LvalId>(l)->name));
+            case Kind::LvalDeref: {
+                Index inner = lval(cast<LvalDeref>(l)->lval);
+                return out.lvals.add(l->kind, inner);
+            }
+            case Kind::LvalArrayAccess: {
+                const LvalArrayAccess* a = cast<LvalArrayAccess>(l);
+                Index ptr = lval(a->ptr);
+                Index index = exp(a->index);
+                return out.lvals.add(l->kind, ptr, index);
+            }
+            default: {
+                const LvalFieldAccess* f = cast<LvalFieldAccess>(l);
+                Index ptr = lval(f->ptr);
+                return out.lvals.add(l->kind, ptr, name(f->field));
+            }
+        }
+    }
+    Index rhs(const AST::Rhs* r) {
+        if (const RhsExp* re = dyn_cast<RhsExp>(r)) {
+            Index e = exp(re->exp);
+            return out.rhss.add(r->kind, e);
+        }
+        const New* n = cast<New>(r);
+        Index t = type(n->type);
+        Index amount = exp(n->amount);
+        return out.rhss.add(r->kind, t, amount);
+    }
+    Index stmts(const vector<AST::Stmt*>& ss) { return list(ss, [this](const AST::Stmt* s) { return stmt(s); }); }
+    Index stmt(const AST::Stmt* s) {
+        switch (s->kind) {
+            case Kind::Return: {
+                Index e = exp(cast<Return>(s)->exp);
+                return out.stmts.add(s->kind, e);
+            }
+            case Kind::Assign: {
+                const Assign* a = cast<Assign>(s);
+                Index lhs = lval(a->lhs);
+                Index r = rhs(a->rhs);
+                return out.stmts.add(s->kind, lhs, r);
+            }
+            case Kind::StmtCall: {
+                const StmtCall* c = cast<StmtCall>(s);
+                Index callee = lval(c->callee);
+                Index args = list(c->args, [this](const Exp* arg) { return exp(arg); });
+                return out.stmts.add(s->kind, callee, args);
+            }
+            case Kind::If: {
+                const If* i = cast<If>(s);
+                Index guard = exp(i->guard);
+                Index tt = stmts(i->tt);
+                Index ff = stmts(i->ff);
+                return out.stmts.add(s->kind, guard, tt, ff);
+            }
+            case Kind::While: {
+                const While* w = cast<While>(s);
+                Index guard = exp(w->guard);
+                Index body = stmts(w->body);
+                return out.stmts.add(s->kind, guard, body);
+            }
+            default: return out.stmts.add(s->kind);
+        }
+    }
+    Index decl(const AST::Decl* d) {
+        Index t = type(d->type);
+        out.decls.name.push_back(name(d->name));
+        out.decls.type.push_back(t);
+        return static_cast<Index>(out.decls.name.size() - 1);
+    }
+    Index decls(const vector<AST::Decl*>& ds) { return list(ds, [this](const AST::Decl* d) { return decl(d); }); }
+    Index structDef(const AST::Struct* s) {
+        Index fields = decls(s->fields);
+        out.structs.name.push_back(name(s->name));
+        out.structs.fields.push_back(fields);
+        return static_cast<Index>(out.structs.name.size() - 1);
+    }
+    Index function(const AST::Function* f) {
+        Index params = decls(f->params);
+        Index rettyp = type(f->rettyp);
+        vector<Index> locals, inits;
+        for (const auto& [d, e]: f->locals) {
+            locals.push_back(decl(d));
+            inits.push_back(exp(e));
+        }
+        Index body = stmts(f->stmts);
+        Functions& fs = out.functions;
+        fs.name.push_back(name(f->name));
+        fs.params.push_back(params);
+        fs.rettyp.push_back(rettyp);
+        fs.locals.push_back(list(locals));
+        fs.inits.push_back(list(inits));
+        fs.stmts.push_back(body);
+        return static_cast<Index>(fs.name.size() - 1);
+    }
+
+    Program run(const AST::Program& prog) {
+        out.globals = decls(prog.globals);
+        out.structDefs = list(prog.structs, [this](const AST::Struct* s) { return structDef(s); });
+        out.externs = decls(prog.externs);
+        out.functionDefs = list(prog.functions, [this](const AST::Function* f) { return function(f); });
+        return std::move(out);
+    }
+};
+
+inline Program flatten(const AST::Program& prog) { return Flattener().run(prog); }
+
+}
+
+#endif
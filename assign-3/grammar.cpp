@@ -1,6 +1,10 @@
 #include <vector>
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <memory>
 #include <iostream>
+#include "../assign-1/pull_lexer.cpp"
 #include "ast.cpp"
 
 class fail : std::exception {
@@ -13,18 +17,29 @@ class fail : std::exception {
 
 struct Grammar {
 
-std::vector<std::string> tokens;
+// Views into the token stream (or the mapped source), which must outlive the parse
+TokenCursor tokens;
+// Where nodes are allocated: the arena of the Program being parsed
+Arena* arena = nullptr;
+
+template<class T>
+T* make() { return arena->make<T>(); }
+
+// The interned name of the identifier at token i
+SymbolId symbol(unsigned int i) { return symbols().intern(tokens[i].text); }
 
 // Notice how all type returns std::pair<Type*, unsigned int>, recursive calls until this is always returned: the current AST struct type and then the next index into the token vector
-// Then binop rules will return std::pair<BinaryOp*, unsigned int>, this behaves similarly
+// A type node is canonicalized as soon as it is complete, so every type in the tree has its canon set
+// Then binop rules will return std::pair<const BinaryOp*, unsigned int>, this behaves similarly
 
 // type ::= `&`* type_ad
 std::pair<Type*, unsigned int> type(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Address") {
-        Ptr* ptr = new Ptr();
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Address) {
+        Ptr* ptr = make<Ptr>();
         auto [ref, inext] = type(i+1);
         ptr->ref = ref;
+        ptr->canonicalize();
         return std::make_pair(ptr, inext);
     }
     return type_ad(i);
@@ -34,16 +49,17 @@ std::pair<Type*, unsigned int> type(unsigned int i) noexcept(false) {
 //           | id
 //           | `(` type_op
 std::pair<Type*, unsigned int> type_ad(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Int") {
-        return std::make_pair(new Int(), i+1);
-    }
-    if (tokens[i].substr(0, 2) == "Id") {
-        StructType* st = new StructType();
-        st->name = tokens[i].substr(3, tokens[i].size()-4);
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Int) {
+        return std::make_pair(singleton<Int>(), i+1);
+    }
+    if (tokens[i].kind == TokenKind::Id) {
+        StructType* st = make<StructType>();
+        st->name = symbol(i);
+        st->canonicalize();
         return std::make_pair(st, i+1);
     }
-    if (tokens[i] == "OpenParen") {
+    if (tokens[i].kind == TokenKind::OpenParen) {
         return type_op(i+1);
     }
     throw fail(i);
@@ -52,9 +68,9 @@ std::pair<Type*, unsigned int> type_ad(unsigned int i) noexcept(false) {
 // type_op ::= `)` type_ar
 //           | type type_fp
 std::pair<Type*, unsigned int> type_op(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "CloseParen") {
-        return type_ar(i+1, new Fn());
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::CloseParen) {
+        return type_ar(i+1, make<Fn>());
     }
     auto [t, itemp] = type(i);
     return type_fp(itemp, t);
@@ -64,27 +80,27 @@ std::pair<Type*, unsigned int> type_op(unsigned int i) noexcept(false) {
 //           | (`,` type)+ `)` type_ar
 // Extra parameter used to keep track of the last parameter passed in
 std::pair<Type*, unsigned int> type_fp(unsigned int i, Type* ti) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "CloseParen") {
-        if (i + 1 < tokens.size() && tokens[i+1] == "Arrow") {
-            Fn* fn = new Fn(); // Creates new function with exactly one parameter (no comma)
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::CloseParen) {
+        if (tokens.has(i + 1) && tokens[i+1].kind == TokenKind::Arrow) {
+            Fn* fn = make<Fn>(); // Creates new function with exactly one parameter (no comma)
             fn->prms.push_back(ti);
             return type_ar(i+1, fn);
         }
         else return std::make_pair(ti, i+1);
     }
-    if (tokens[i] == "Comma") {
-        Fn* fn = new Fn(); // Creates function with at least two parameters
+    if (tokens[i].kind == TokenKind::Comma) {
+        Fn* fn = make<Fn>(); // Creates function with at least two parameters
         fn->prms.push_back(ti);
         auto [t, itemp] = type(i+1); // itemp will store next token to look at
         fn->prms.push_back(t);
-        while (itemp < tokens.size()) {
-            if (tokens[itemp] == "Comma") {
+        while (tokens.has(itemp)) {
+            if (tokens[itemp].kind == TokenKind::Comma) {
                 auto [new_t, new_itemp] = type(itemp+1);
                 fn->prms.push_back(new_t);
                 itemp = new_itemp;
             }
-            else if (tokens[itemp] == "CloseParen") return type_ar(itemp+1, fn);
+            else if (tokens[itemp].kind == TokenKind::CloseParen) return type_ar(itemp+1, fn);
             else throw fail(itemp);
         }
         throw fail(itemp);
@@ -94,10 +110,11 @@ std::pair<Type*, unsigned int> type_fp(unsigned int i, Type* ti) noexcept(false)
 
 // type_ar ::= `->` rettyp
 std::pair<Type*, unsigned int> type_ar(unsigned int i, Fn* fn) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Arrow") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Arrow) {
         auto [t, itemp] = rettyp(i+1);
         fn->ret = t;
+        fn->canonicalize();
         return std::make_pair(fn, itemp);
     }
     throw fail(i);
@@ -105,15 +122,15 @@ std::pair<Type*, unsigned int> type_ar(unsigned int i, Fn* fn) noexcept(false) {
 
 // funtype ::= `(` (type (`,` type)*)? `)` `->` rettyp
 std::pair<Type*, unsigned int> funtype(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    Fn* fn = new Fn();
-    if (tokens[i] == "OpenParen") {
-        if (i + 1 < tokens.size() && (tokens[i+1] == "Address" || tokens[i+1].substr(0, 2) == "Id" || tokens[i+1] == "OpenParen" || tokens[i+1] == "Int")) {
+    if (!tokens.has(i)) throw fail(i);
+    Fn* fn = make<Fn>();
+    if (tokens[i].kind == TokenKind::OpenParen) {
+        if (tokens.has(i + 1) && (tokens[i+1].kind == TokenKind::Address || tokens[i+1].kind == TokenKind::Id || tokens[i+1].kind == TokenKind::OpenParen || tokens[i+1].kind == TokenKind::Int)) {
             auto [t, itemp] = type(i+1);
             fn->prms.push_back(t);
             i = itemp-1; // index of the last type
-            while (itemp < tokens.size()) {
-                if (tokens[itemp] == "Comma") {
+            while (tokens.has(itemp)) {
+                if (tokens[itemp].kind == TokenKind::Comma) {
                     auto [another_t, another_itemp] = type(itemp+1); // returns index after type to check
                     fn->prms.push_back(another_t);
                     itemp = another_itemp;
@@ -122,10 +139,11 @@ std::pair<Type*, unsigned int> funtype(unsigned int i) noexcept(false) {
                 else break;
             }
         }
-        if (i + 1 < tokens.size() && tokens[i+1] == "CloseParen") {
-            if (i + 2 < tokens.size() && tokens[i+2] == "Arrow") {
+        if (tokens.has(i + 1) && tokens[i+1].kind == TokenKind::CloseParen) {
+            if (tokens.has(i + 2) && tokens[i+2].kind == TokenKind::Arrow) {
                 auto [t, itemp] = rettyp(i+3);
                 fn->ret = t;
+                fn->canonicalize();
                 return std::make_pair(fn, itemp);
             }
             else throw fail(i+2);
@@ -138,47 +156,47 @@ std::pair<Type*, unsigned int> funtype(unsigned int i) noexcept(false) {
 // rettyp ::= type 
 //           | `_`
 std::pair<Type*, unsigned int> rettyp(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Underscore") {
-        return std::make_pair(new Any(), i+1);
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Underscore) {
+        return std::make_pair(singleton<Any>(), i+1);
     }
     return type(i);
 }
 
 // unop ::= `*`
 //        | `-`
-std::pair<UnaryOp*, unsigned int> unop(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Star") return std::make_pair(new UnaryDeref(), i+1);
-    if (tokens[i] == "Dash") return std::make_pair(new Neg(), i+1);
+std::pair<const UnaryOp*, unsigned int> unop(unsigned int i) noexcept(false) {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Star) return std::make_pair(singleton<UnaryDeref>(), i+1);
+    if (tokens[i].kind == TokenKind::Dash) return std::make_pair(singleton<Neg>(), i+1);
     throw fail(i);
 }
 
 // binop_p1 ::= `*` | `/`
-std::pair<BinaryOp*, unsigned int> binop_p1(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Star") return std::make_pair(new Mul(), i+1);
-    if (tokens[i] == "Slash") return std::make_pair(new Div(), i+1);
+std::pair<const BinaryOp*, unsigned int> binop_p1(unsigned int i) noexcept(false) {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Star) return std::make_pair(singleton<Mul>(), i+1);
+    if (tokens[i].kind == TokenKind::Slash) return std::make_pair(singleton<Div>(), i+1);
     throw fail(i);
 }
 
 // binop_p2 ::= `+` | `-`
-std::pair<BinaryOp*, unsigned int> binop_p2(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Plus") return std::make_pair(new Add(), i+1);
-    if (tokens[i] == "Dash") return std::make_pair(new Sub(), i+1);
+std::pair<const BinaryOp*, unsigned int> binop_p2(unsigned int i) noexcept(false) {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Plus) return std::make_pair(singleton<Add>(), i+1);
+    if (tokens[i].kind == TokenKind::Dash) return std::make_pair(singleton<Sub>(), i+1);
     throw fail(i);
 }
 
 // binop_p3 ::= `==` | `!=` | `<` | `<=` | `>` | `>=`
-std::pair<BinaryOp*, unsigned int> binop_p3(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Equal") return std::make_pair(new Equal(), i+1);
-    if (tokens[i] == "NotEq") return std::make_pair(new NotEq(), i+1);
-    if (tokens[i] == "Lt") return std::make_pair(new Lt(), i+1);
-    if (tokens[i] == "Lte") return std::make_pair(new Lte(), i+1);
-    if (tokens[i] == "Gt") return std::make_pair(new Gt(), i+1);
-    if (tokens[i] == "Gte") return std::make_pair(new Gte(), i+1);
+std::pair<const BinaryOp*, unsigned int> binop_p3(unsigned int i) noexcept(false) {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Equal) return std::make_pair(singleton<Equal>(), i+1);
+    if (tokens[i].kind == TokenKind::NotEq) return std::make_pair(singleton<NotEq>(), i+1);
+    if (tokens[i].kind == TokenKind::Lt) return std::make_pair(singleton<Lt>(), i+1);
+    if (tokens[i].kind == TokenKind::Lte) return std::make_pair(singleton<Lte>(), i+1);
+    if (tokens[i].kind == TokenKind::Gt) return std::make_pair(singleton<Gt>(), i+1);
+    if (tokens[i].kind == TokenKind::Gte) return std::make_pair(singleton<Gte>(), i+1);
     throw fail(i);
 }
 
@@ -186,23 +204,23 @@ std::pair<BinaryOp*, unsigned int> binop_p3(unsigned int i) noexcept(false) {
 
 // exp ::= exp_p4 (binop_p3 exp_p4)*
 std::pair<Exp*, unsigned int> exp(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
+    if (!tokens.has(i)) throw fail(i);
     auto [lref, inext] = exp_p4(i);
     BinOp* binop = nullptr;
-    while (inext < tokens.size()) {
-        if (tokens[inext] == "Equal" || tokens[inext] == "NotEq" || tokens[inext] == "Lt" || tokens[inext] == "Lte" || tokens[inext] == "Gt" || tokens[inext] == "Gte") {
+    while (tokens.has(inext)) {
+        if (tokens[inext].kind == TokenKind::Equal || tokens[inext].kind == TokenKind::NotEq || tokens[inext].kind == TokenKind::Lt || tokens[inext].kind == TokenKind::Lte || tokens[inext].kind == TokenKind::Gt || tokens[inext].kind == TokenKind::Gte) {
             auto [opref, itemp] = binop_p3(inext);
             auto [rref, another_itemp] = exp_p4(inext+1);
             inext = another_itemp;
 
             if (!binop) {
-                binop = new BinOp();
+                binop = make<BinOp>();
                 binop->op = opref;
                 binop->left = lref;
                 binop->right = rref;    
             }
             else {
-                BinOp* binop2 = new BinOp();
+                BinOp* binop2 = make<BinOp>();
                 binop2->op = opref;
                 binop2->left = binop;
                 binop2->right = rref;
@@ -217,23 +235,23 @@ std::pair<Exp*, unsigned int> exp(unsigned int i) noexcept(false) {
 
 // exp_p4 ::= exp_p3 (binop_p2 exp_p3)*
 std::pair<Exp*, unsigned int> exp_p4(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
+    if (!tokens.has(i)) throw fail(i);
     auto [lref, inext] = exp_p3(i);
     BinOp* binop = nullptr;
-    while (inext < tokens.size()) {
-        if (tokens[inext] == "Plus" || tokens[inext] == "Dash") {
+    while (tokens.has(inext)) {
+        if (tokens[inext].kind == TokenKind::Plus || tokens[inext].kind == TokenKind::Dash) {
             auto [opref, itemp] = binop_p2(inext);
             auto [rref, another_itemp] = exp_p3(itemp);
             inext = another_itemp;
 
             if (!binop) {
-                binop = new BinOp();
+                binop = make<BinOp>();
                 binop->op = opref;
                 binop->left = lref;
                 binop->right = rref;
             }
             else {
-                BinOp* binop2 = new BinOp();
+                BinOp* binop2 = make<BinOp>();
                 binop2->op = opref;
                 binop2->left = binop;
                 binop2->right = rref;
@@ -248,23 +266,23 @@ std::pair<Exp*, unsigned int> exp_p4(unsigned int i) noexcept(false) {
 
 // exp_p3 ::= exp_p2 (binop_p1 exp_p2)*
 std::pair<Exp*, unsigned int> exp_p3(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
+    if (!tokens.has(i)) throw fail(i);
     auto [lref, inext] = exp_p2(i);
     BinOp* binop = nullptr;
-    while (inext < tokens.size()) {
-        if (tokens[inext] == "Star" || tokens[inext] == "Slash") {
+    while (tokens.has(inext)) {
+        if (tokens[inext].kind == TokenKind::Star || tokens[inext].kind == TokenKind::Slash) {
             auto [opref, itemp] = binop_p1(inext);
             auto [rref, another_itemp] = exp_p2(itemp);
             inext = another_itemp;
 
             if (!binop) {
-                binop = new BinOp();
+                binop = make<BinOp>();
                 binop->op = opref;
                 binop->left = lref;
                 binop->right = rref;    
             }
             else {
-                BinOp* binop2 = new BinOp();
+                BinOp* binop2 = make<BinOp>();
                 binop2->op = opref;
                 binop2->left = binop;
                 binop2->right = rref;
@@ -279,11 +297,11 @@ std::pair<Exp*, unsigned int> exp_p3(unsigned int i) noexcept(false) {
 
 // exp_p2 ::= unop* exp_p1
 std::pair<Exp*, unsigned int> exp_p2(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Star" || tokens[i] == "Dash") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Star || tokens[i].kind == TokenKind::Dash) {
         auto [op, itemp] = unop(i);
         auto [operand, inext] = exp_p2(itemp);
-        UnOp* unop = new UnOp();
+        UnOp* unop = make<UnOp>();
         unop->op = op;
         unop->operand = operand;
         return std::make_pair(unop, inext);
@@ -296,27 +314,26 @@ std::pair<Exp*, unsigned int> exp_p2(unsigned int i) noexcept(false) {
 //          | `(` exp `)`
 //          | id exp_ac*
 std::pair<Exp*, unsigned int> exp_p1(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i].substr(0, 3) == "Num") {
-        Num* num = new Num();
-        try {
-            num->n = std::stoi(tokens[i].substr(4, tokens[i].size() - 5));
-        } catch (std::exception& e) { throw fail(i); }
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Num) {
+        Num* num = make<Num>();
+        std::string_view digits = tokens[i].text;
+        if (std::from_chars(digits.data(), digits.data() + digits.size(), num->n).ec != std::errc()) throw fail(i);
         return std::make_pair(num, i+1);
     }
-    if (tokens[i] == "Nil") { return std::make_pair(new Nil(), i+1); }
-    if (tokens[i] == "OpenParen") {
+    if (tokens[i].kind == TokenKind::Nil) { return std::make_pair(make<Nil>(), i+1); }
+    if (tokens[i].kind == TokenKind::OpenParen) {
         auto [e, itemp] = exp(i+1);
-        if (itemp < tokens.size() && tokens[itemp] == "CloseParen") { return std::make_pair(e, itemp+1); }
+        if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::CloseParen) { return std::make_pair(e, itemp+1); }
         else throw fail(itemp);
     }
-    if (tokens[i].substr(0, 2) == "Id") {
-        ExpId* expid = new ExpId();
-        expid->name = tokens[i].substr(3, tokens[i].size() - 4); 
+    if (tokens[i].kind == TokenKind::Id) {
+        ExpId* expid = make<ExpId>();
+        expid->name = symbol(i); 
         Exp* ret = expid;
         unsigned int itemp = i+1;
-        while (itemp < tokens.size()) {
-            if (tokens[itemp] == "OpenBracket" || tokens[itemp] == "Dot" || tokens[itemp] == "OpenParen") {
+        while (tokens.has(itemp)) {
+            if (tokens[itemp].kind == TokenKind::OpenBracket || tokens[itemp].kind == TokenKind::Dot || tokens[itemp].kind == TokenKind::OpenParen) {
                 auto [e, inext] = exp_ac(itemp, ret);
                 ret = e;
                 itemp = inext;
@@ -333,38 +350,38 @@ std::pair<Exp*, unsigned int> exp_p1(unsigned int i) noexcept(false) {
 //          | `.` id
 //          | `(` args? `)`
 std::pair<Exp*, unsigned int> exp_ac(unsigned int i, Exp* e) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "OpenBracket") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::OpenBracket) {
         auto [another_e, itemp] = exp(i+1);
-        if (itemp < tokens.size() && tokens[itemp] == "CloseBracket") {
-            ExpArrayAccess* eaa = new ExpArrayAccess();
+        if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::CloseBracket) {
+            ExpArrayAccess* eaa = make<ExpArrayAccess>();
             eaa->ptr = e;
             eaa->index = another_e;
             return std::make_pair(eaa, itemp+1);
         }
         else throw fail(itemp);
     }
-    if (tokens[i] == "Dot") {
-        if (i+1 < tokens.size() && tokens[i+1].substr(0, 2) == "Id") {
-            ExpFieldAccess* efa = new ExpFieldAccess();
+    if (tokens[i].kind == TokenKind::Dot) {
+        if (tokens.has(i+1) && tokens[i+1].kind == TokenKind::Id) {
+            ExpFieldAccess* efa = make<ExpFieldAccess>();
             efa->ptr = e;
-            efa->field = tokens[i+1].substr(3, tokens[i+1].size()-4);
+            efa->field = symbol(i+1);
             return std::make_pair(efa, i+2);
         }
         else throw fail(i+1);
     }
-    else if (tokens[i] == "OpenParen") {
-        ExpCall* ec = new ExpCall();
+    else if (tokens[i].kind == TokenKind::OpenParen) {
+        ExpCall* ec = make<ExpCall>();
         ec -> callee = e;
-        if (i + 1 < tokens.size() && tokens[i+1] != "CloseParen") {
+        if (tokens.has(i + 1) && tokens[i+1].kind != TokenKind::CloseParen) {
             auto [list_e, itemp] = args(i+1);
-            if (itemp < tokens.size() && tokens[itemp] == "CloseParen") {
+            if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::CloseParen) {
                 ec->args = list_e;
                 return std::make_pair(ec, itemp+1);
             }
             else throw fail(itemp);
         }
-        else if (i+1 < tokens.size() && tokens[i+1] == "CloseParen") return std::make_pair(ec, i+2);
+        else if (tokens.has(i+1) && tokens[i+1].kind == TokenKind::CloseParen) return std::make_pair(ec, i+2);
         else throw fail(i+1);
     }
     throw fail(i);
@@ -372,12 +389,12 @@ std::pair<Exp*, unsigned int> exp_ac(unsigned int i, Exp* e) noexcept(false) {
 
 // args ::= exp (`,` exp)*
 std::pair<std::vector<Exp*>, unsigned int> args(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
+    if (!tokens.has(i)) throw fail(i);
     std::vector<Exp*> vec;
     auto [e, itemp] = exp(i);
     vec.push_back(e);
-    while (itemp < tokens.size()) {
-        if (tokens[itemp] == "Comma") {
+    while (tokens.has(itemp)) {
+        if (tokens[itemp].kind == TokenKind::Comma) {
             auto [another_e, inext] = exp(itemp+1);
             vec.push_back(another_e);
             itemp = inext;
@@ -389,20 +406,20 @@ std::pair<std::vector<Exp*>, unsigned int> args(unsigned int i) noexcept(false)
 
 // lval ::= `*`* id access*
 std::pair<Lval*, unsigned int> lval(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Star") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Star) {
         auto [lval1, itemp] = lval(i+1);
-        LvalDeref* lvd = new LvalDeref();
+        LvalDeref* lvd = make<LvalDeref>();
         lvd->lval = lval1;
         return std::make_pair(lvd, itemp);
     }
-    if (tokens[i].substr(0, 2) == "Id") {
-        LvalId* lvalid = new LvalId();
-        lvalid->name = tokens[i].substr(3, tokens[i].size() - 4);
+    if (tokens[i].kind == TokenKind::Id) {
+        LvalId* lvalid = make<LvalId>();
+        lvalid->name = symbol(i);
         Lval* ret = lvalid;
         unsigned int itemp = i+1;
-        while (itemp < tokens.size()) {
-            if (tokens[itemp] == "OpenBracket" || tokens[itemp] == "Dot") {
+        while (tokens.has(itemp)) {
+            if (tokens[itemp].kind == TokenKind::OpenBracket || tokens[itemp].kind == TokenKind::Dot) {
                 auto [lv, inext] = access(itemp, ret);
                 ret = lv;
                 itemp = inext;
@@ -417,22 +434,22 @@ std::pair<Lval*, unsigned int> lval(unsigned int i) noexcept(false) {
 // access ::= `[` exp `]` 
 //          | `.` id
 std::pair<Lval*, unsigned int> access(unsigned int i, Lval* lv) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "OpenBracket") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::OpenBracket) {
         auto [e, itemp] = exp(i+1);
-        if (itemp < tokens.size() && tokens[itemp] == "CloseBracket") {
-            LvalArrayAccess* laa = new LvalArrayAccess();
+        if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::CloseBracket) {
+            LvalArrayAccess* laa = make<LvalArrayAccess>();
             laa->ptr = lv;
             laa->index = e;
             return std::make_pair(laa, itemp+1);
         }
         else throw fail(itemp);
     }
-    if (tokens[i] == "Dot") {
-        if (i+1 < tokens.size() && tokens[i+1].substr(0, 2) == "Id") {
-            LvalFieldAccess* lfa = new LvalFieldAccess();
+    if (tokens[i].kind == TokenKind::Dot) {
+        if (tokens.has(i+1) && tokens[i+1].kind == TokenKind::Id) {
+            LvalFieldAccess* lfa = make<LvalFieldAccess>();
             lfa->ptr = lv;
-            lfa->field = tokens[i+1].substr(3, tokens[i+1].size()-4);
+            lfa->field = symbol(i+1);
             return std::make_pair(lfa, i+2);
         }
         else throw fail(i+1);
@@ -442,7 +459,7 @@ std::pair<Lval*, unsigned int> access(unsigned int i, Lval* lv) noexcept(false)
 
 // assign_or_call ::= lval gets_or_args
 std::pair<Stmt*, unsigned int> assign_or_call(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
+    if (!tokens.has(i)) throw fail(i);
     auto [lv, itemp] = lval(i);
     return gets_or_args(itemp, lv);
 }
@@ -450,26 +467,26 @@ std::pair<Stmt*, unsigned int> assign_or_call(unsigned int i) noexcept(false) {
 // gets_or_args ::= `=` rhs
 //                | `(` args? `)`
 std::pair<Stmt*, unsigned int> gets_or_args(unsigned int i, Lval* lv) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Gets") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Gets) {
         auto [r, itemp] = rhs(i+1);
-        Assign* assign = new Assign();
+        Assign* assign = make<Assign>();
         assign->lhs = lv;
         assign->rhs = r;
         return std::make_pair(assign, itemp);
     }
-    if (tokens[i] == "OpenParen") {
-        StmtCall* stmtcall = new StmtCall();
+    if (tokens[i].kind == TokenKind::OpenParen) {
+        StmtCall* stmtcall = make<StmtCall>();
         stmtcall->callee = lv;
-        if (i + 1 < tokens.size() && tokens[i+1] != "CloseParen") {
+        if (tokens.has(i + 1) && tokens[i+1].kind != TokenKind::CloseParen) {
             auto [exps, itemp] = args(i+1);
-            if (itemp < tokens.size() && tokens[itemp] == "CloseParen") {
+            if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::CloseParen) {
                 stmtcall->args = exps;
                 return std::make_pair(stmtcall, itemp+1);
             }
             else throw fail(itemp);
         }
-        else if (i + 1 < tokens.size() && tokens[i+1] == "CloseParen") return std::make_pair(stmtcall, i+2);
+        else if (tokens.has(i + 1) && tokens[i+1].kind == TokenKind::CloseParen) return std::make_pair(stmtcall, i+2);
         else throw fail(i+1);
     }
     throw fail(i);
@@ -478,35 +495,35 @@ std::pair<Stmt*, unsigned int> gets_or_args(unsigned int i, Lval* lv) noexcept(f
 // rhs ::= exp 
 //       | `new` type exp?
 std::pair<Rhs*, unsigned int> rhs(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "New") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::New) {
         auto [t, itemp1] = type(i+1);
-        New* n = new New(); // too many news :)
+        New* n = make<New>(); // too many news :)
         n->type = t;
-        if (itemp1 < tokens.size() && (tokens[itemp1] == "Star" || tokens[itemp1] == "Dash" || tokens[itemp1].substr(0, 3) == "Num" || tokens[itemp1] == "Nil" || tokens[itemp1] == "OpenParen" || tokens[itemp1].substr(0, 2) == "Id")) {
+        if (tokens.has(itemp1) && (tokens[itemp1].kind == TokenKind::Star || tokens[itemp1].kind == TokenKind::Dash || tokens[itemp1].kind == TokenKind::Num || tokens[itemp1].kind == TokenKind::Nil || tokens[itemp1].kind == TokenKind::OpenParen || tokens[itemp1].kind == TokenKind::Id)) {
             auto [e, itemp2] = exp(itemp1);
             n->amount = e;
             return std::make_pair(n, itemp2);
         }
-        Num* num = new Num(); // if no exp is in place for new, create Num(1) as exp
+        Num* num = make<Num>(); // if no exp is in place for new, create Num(1) as exp
         num->n = 1;
         n->amount = num;
         return std::make_pair(n, itemp1);
     }
     auto [e, itemp] = exp(i);
-    RhsExp* rhse = new RhsExp();
+    RhsExp* rhse = make<RhsExp>();
     rhse->exp = e;
     return std::make_pair(rhse, itemp);
 }
 
 // decl ::= id `:` type
 std::pair<Decl*, unsigned int> decl(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i].substr(0, 2) == "Id") {
-        if (i + 1 < tokens.size() && tokens[i+1] == "Colon") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Id) {
+        if (tokens.has(i + 1) && tokens[i+1].kind == TokenKind::Colon) {
+            Decl* d = make<Decl>();
+            d->name = symbol(i); // before type() moves the token window on
             auto [t, itemp] = type(i+2);
-            Decl* d = new Decl();
-            d->name = tokens[i].substr(3, tokens[i].size()-4);
             d->type = t;
             return std::make_pair(d, itemp);
         }
@@ -517,12 +534,12 @@ std::pair<Decl*, unsigned int> decl(unsigned int i) noexcept(false) {
 
 // decls ::= decl (`,` decl)*
 std::pair<std::vector<Decl*>, unsigned int> decls(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
+    if (!tokens.has(i)) throw fail(i);
     std::vector<Decl*> vec;
     auto [d, itemp] = decl(i);
     vec.push_back(d);
-    while (itemp < tokens.size()) {
-        if (tokens[itemp] == "Comma") {
+    while (tokens.has(itemp)) {
+        if (tokens[itemp].kind == TokenKind::Comma) {
             auto [another_d, inext] = decl(itemp+1);
             vec.push_back(another_d);
             itemp = inext;
@@ -534,18 +551,19 @@ std::pair<std::vector<Decl*>, unsigned int> decls(unsigned int i) noexcept(false
 
 // extern ::= `extern` id `:` funtype `;`
 std::pair<Decl*, unsigned int> exter(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Extern") {
-        if (i + 1 < tokens.size() && tokens[i+1].substr(0, 2) == "Id") {
-            if (i + 2 < tokens.size() && tokens[i+2] == "Colon") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Extern) {
+        if (tokens.has(i + 1) && tokens[i+1].kind == TokenKind::Id) {
+            if (tokens.has(i + 2) && tokens[i+2].kind == TokenKind::Colon) {
+                SymbolId name = symbol(i+1); // before funtype() moves the token window on
                 auto [t, itemp] = funtype(i+3);
-                if (itemp < tokens.size() && tokens[itemp] == "Semicolon") {
-                    Decl* dec = new Decl();
-                    dec->name = tokens[i+1].substr(3, tokens[i+1].size() - 4);
+                if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::Semicolon) {
+                    Decl* dec = make<Decl>();
+                    dec->name = name;
                     dec->type = t;
                     return std::make_pair(dec, itemp+1);
                 }
-                if (itemp < tokens.size()) throw fail(itemp);
+                if (tokens.has(itemp)) throw fail(itemp);
                 else throw fail(-1);
             }
             else throw fail(i+2);
@@ -557,26 +575,26 @@ std::pair<Decl*, unsigned int> exter(unsigned int i) noexcept(false) {
 
 // fundef ::= `fn` id `(` decls? `)` `->` rettyp `{` let* stmt+ `}`
 std::pair<Function*, unsigned int> fundef(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Fn") {
-        if (i + 1 < tokens.size() && tokens[i+1].substr(0, 2) == "Id") {
-            if (i + 2 < tokens.size() && tokens[i+2] == "OpenParen") {
-                Function* func = new Function();
-                func->name = tokens[i+1].substr(3, tokens[i+1].size()-4);
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Fn) {
+        if (tokens.has(i + 1) && tokens[i+1].kind == TokenKind::Id) {
+            if (tokens.has(i + 2) && tokens[i+2].kind == TokenKind::OpenParen) {
+                Function* func = make<Function>();
+                func->name = symbol(i+1);
                 unsigned int itemp = i+3;
-                if (itemp < tokens.size() && tokens[itemp].substr(0, 2) == "Id") {
+                if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::Id) {
                     auto [dec, itemp1] = decls(itemp);
                     func->params = dec;
                     itemp = itemp1;
                 }
-                if (itemp < tokens.size() && tokens[itemp] == "CloseParen") {
-                    if (itemp + 1 < tokens.size() && tokens[itemp+1] == "Arrow") {
+                if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::CloseParen) {
+                    if (tokens.has(itemp + 1) && tokens[itemp+1].kind == TokenKind::Arrow) {
                         auto [ret, itemp1] = rettyp(itemp+2);
                         func->rettyp = ret;
-                        if (itemp1 < tokens.size() && tokens[itemp1] == "OpenBrace") {
+                        if (tokens.has(itemp1) && tokens[itemp1].kind == TokenKind::OpenBrace) {
                             itemp1++;
-                            while (itemp1 < tokens.size()) {
-                                if (tokens[itemp1] == "Let") {
+                            while (tokens.has(itemp1)) {
+                                if (tokens[itemp1].kind == TokenKind::Let) {
                                     auto [vec, inext] = let(itemp1);
                                     for (auto pair: vec) func->locals.push_back(pair);
                                     itemp1 = inext;
@@ -586,15 +604,15 @@ std::pair<Function*, unsigned int> fundef(unsigned int i) noexcept(false) {
                             auto [s, itemp2] = stmt(itemp1);
                             itemp1 = itemp2;
                             func->stmts.push_back(s);
-                            while (itemp1 < tokens.size()) {
-                                if (tokens[itemp1] != "CloseBrace") {
+                            while (tokens.has(itemp1)) {
+                                if (tokens[itemp1].kind != TokenKind::CloseBrace) {
                                     auto [another_s, inext] = stmt(itemp1);
                                     func->stmts.push_back(another_s);
                                     itemp1 = inext;
                                 }
                                 else break;
                             }
-                            if (itemp1 < tokens.size() && tokens[itemp1] == "CloseBrace") return std::make_pair(func, itemp1+1);
+                            if (tokens.has(itemp1) && tokens[itemp1].kind == TokenKind::CloseBrace) return std::make_pair(func, itemp1+1);
                             else throw fail(-1);
                         }
                         else throw fail(itemp1);
@@ -615,20 +633,20 @@ std::pair<Function*, unsigned int> fundef(unsigned int i) noexcept(false) {
 // rewriting this to the following:
 // let ::= `let` intermediate_let (`,` intermediate_let)* `;`
 std::pair<std::vector<std::pair<Decl*, Exp*>>, unsigned int> let(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Let") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Let) {
         std::vector<std::pair<Decl*, Exp*>> vec;
         auto [pair, itemp] = intermediate_let(i+1);
         vec.push_back(pair);
-        while (itemp < tokens.size()) {
-            if (tokens[itemp] == "Comma") {
+        while (tokens.has(itemp)) {
+            if (tokens[itemp].kind == TokenKind::Comma) {
                 auto [another_pair, inext] = intermediate_let(itemp+1);
                 vec.push_back(another_pair);
                 itemp = inext;
             }
             else break;
         }
-        if (itemp < tokens.size() && tokens[itemp] == "Semicolon") return std::make_pair(vec, itemp+1);
+        if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::Semicolon) return std::make_pair(vec, itemp+1);
         else throw fail(itemp);
     }
     throw fail(i);
@@ -636,14 +654,14 @@ std::pair<std::vector<std::pair<Decl*, Exp*>>, unsigned int> let(unsigned int i)
 
 // intermediate_let ::= decl (`=` exp)?
 std::pair<std::pair<Decl*, Exp*>, unsigned int> intermediate_let(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
+    if (!tokens.has(i)) throw fail(i);
     auto [d, itemp] = decl(i);
-    if (itemp < tokens.size() && tokens[itemp] == "Gets") {
+    if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::Gets) {
         auto [e, itemp1] = exp(itemp+1);
         std::pair<Decl*, Exp*> p = std::make_pair(d, e);
         return std::make_pair(p, itemp1);
     }
-    std::pair<Decl*, Exp*> p = std::make_pair(d, new AnyExp());
+    std::pair<Decl*, Exp*> p = std::make_pair(d, make<AnyExp>());
     return std::make_pair(p, itemp);
 }
 
@@ -654,31 +672,31 @@ std::pair<std::pair<Decl*, Exp*>, unsigned int> intermediate_let(unsigned int i)
 //        | `continue` `;`     # continue to next iteration of loop
 //        | `return` exp? `;`  # return from function
 std::pair<Stmt*, unsigned int> stmt(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "If") return cond(i);
-    if (tokens[i] == "While") return loop(i);
-    if (tokens[i] == "Star" || tokens[i].substr(0, 2) == "Id") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::If) return cond(i);
+    if (tokens[i].kind == TokenKind::While) return loop(i);
+    if (tokens[i].kind == TokenKind::Star || tokens[i].kind == TokenKind::Id) {
         auto [res, itemp] = assign_or_call(i);
-        if (itemp < tokens.size() && tokens[itemp] == "Semicolon") return std::make_pair(res, itemp+1);
+        if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::Semicolon) return std::make_pair(res, itemp+1);
         else throw fail(itemp);
     }
-    if (tokens[i] == "Break") {
-        if (i + 1 < tokens.size() && tokens[i+1] == "Semicolon") {
-            return std::make_pair(new Break(), i+2);
+    if (tokens[i].kind == TokenKind::Break) {
+        if (tokens.has(i + 1) && tokens[i+1].kind == TokenKind::Semicolon) {
+            return std::make_pair(make<Break>(), i+2);
         }
         else throw fail(i+1);
     }
-    if (tokens[i] == "Continue") {
-        if (i + 1 < tokens.size() && tokens[i+1] == "Semicolon") {
-            return std::make_pair(new Continue(), i+2);
+    if (tokens[i].kind == TokenKind::Continue) {
+        if (tokens.has(i + 1) && tokens[i+1].kind == TokenKind::Semicolon) {
+            return std::make_pair(make<Continue>(), i+2);
         }
         else throw fail(i+1);
     }
-    if (tokens[i] == "Return") {
-        if (i+1 < tokens.size() && tokens[i+1] != "Semicolon") {
+    if (tokens[i].kind == TokenKind::Return) {
+        if (tokens.has(i+1) && tokens[i+1].kind != TokenKind::Semicolon) {
             auto [e, itemp] = exp(i+1);
-            if (itemp < tokens.size() && tokens[itemp] == "Semicolon") {
-                Return* ret = new Return();
+            if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::Semicolon) {
+                Return* ret = make<Return>();
                 ret->exp = e;
                 return std::make_pair(ret, itemp+1);
             }
@@ -686,9 +704,9 @@ std::pair<Stmt*, unsigned int> stmt(unsigned int i) noexcept(false) {
                 throw fail(itemp);
             }
         }
-        else if (i+1 < tokens.size() && tokens[i+1] == "Semicolon") {
-            Return* ret = new Return();
-            AnyExp* any = new AnyExp();
+        else if (tokens.has(i+1) && tokens[i+1].kind == TokenKind::Semicolon) {
+            Return* ret = make<Return>();
+            AnyExp* any = make<AnyExp>();
             ret->exp = any;
             return std::make_pair(ret, i+2);
         }
@@ -700,14 +718,14 @@ std::pair<Stmt*, unsigned int> stmt(unsigned int i) noexcept(false) {
 
 // cond ::= `if` exp block (`else` block)?
 std::pair<Stmt*, unsigned int> cond(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "If") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::If) {
         auto [e, itemp] = exp(i+1);
         auto [vec, itemp1] = block(itemp);
-        If* ifs = new If();
+        If* ifs = make<If>();
         ifs->guard = e;
         ifs->tt = vec;
-        if (itemp1 < tokens.size() && tokens[itemp1] == "Else") {
+        if (tokens.has(itemp1) && tokens[itemp1].kind == TokenKind::Else) {
             auto [another_vec, itemp2] = block(itemp1+1);
             ifs->ff = another_vec;
             itemp1 = itemp2;
@@ -719,11 +737,11 @@ std::pair<Stmt*, unsigned int> cond(unsigned int i) noexcept(false) {
 
 // loop ::= `while` exp block 
 std::pair<Stmt*, unsigned int> loop(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "While") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::While) {
         auto [e, itemp] = exp(i+1);
         auto [vec, itemp1] = block(itemp);
-        While* wh = new While();
+        While* wh = make<While>();
         wh->guard = e;
         wh->body = vec;
         return std::make_pair(wh, itemp1);
@@ -733,19 +751,19 @@ std::pair<Stmt*, unsigned int> loop(unsigned int i) noexcept(false) {
 
 // block ::= `{` stmt* `}`
 std::pair<std::vector<Stmt*>, unsigned int> block(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "OpenBrace") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::OpenBrace) {
         std::vector<Stmt*> vec;
         unsigned int itemp = i+1;
-        while (itemp < tokens.size()) {
-            if (tokens[itemp] != "CloseBrace") {
+        while (tokens.has(itemp)) {
+            if (tokens[itemp].kind != TokenKind::CloseBrace) {
                 auto [s, inext] = stmt(itemp);
                 vec.push_back(s);
                 itemp = inext;
             }
             else break;
         }
-        if (itemp < tokens.size() && tokens[itemp] == "CloseBrace") return std::make_pair(vec, itemp+1);
+        if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::CloseBrace) return std::make_pair(vec, itemp+1);
         else throw fail(-1);
     }
     throw fail(i);
@@ -753,13 +771,14 @@ std::pair<std::vector<Stmt*>, unsigned int> block(unsigned int i) noexcept(false
 
 //  program ::= toplevel+
 Program* program(unsigned int i) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    Program* prog = new Program();
-    unsigned int itemp = toplevel(i, prog);
-    while (itemp < tokens.size()) {
-        itemp = toplevel(itemp, prog);
-    }
-    if (itemp == tokens.size()) return prog;
+    if (!tokens.has(i)) throw fail(i);
+    std::unique_ptr<Program> prog(new Program()); // a parse error frees the partial tree
+    arena = &prog->arena;
+    unsigned int itemp = toplevel(i, prog.get());
+    while (tokens.has(itemp)) {
+        itemp = toplevel(itemp, prog.get());
+    }
+    if (!tokens.has(itemp)) return prog.release();
     throw fail(itemp);
 }
 
@@ -768,23 +787,23 @@ Program* program(unsigned int i) noexcept(false) {
 //            | extern    # external function declaration
 //            | fundef    # function definition
 unsigned int toplevel(unsigned int i, Program* prog) noexcept(false) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Let") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Let) {
         auto [vec_globals, itemp] = glob(i);
         for (auto global: vec_globals) prog->globals.push_back(global);
         return itemp;
     }
-    else if (tokens[i] == "Struct") { 
+    else if (tokens[i].kind == TokenKind::Struct) { 
         auto [str, itemp] = typedefn(i);
         prog->structs.push_back(str);
         return itemp;
     }
-    else if (tokens[i] == "Extern") {
+    else if (tokens[i].kind == TokenKind::Extern) {
         auto [dec, itemp] = exter(i);
         prog->externs.push_back(dec);
         return itemp;
     }
-    else if (tokens[i] == "Fn") {
+    else if (tokens[i].kind == TokenKind::Fn) {
         auto [function, itemp] = fundef(i);
         prog->functions.push_back(function);
         return itemp;
@@ -795,11 +814,11 @@ unsigned int toplevel(unsigned int i, Program* prog) noexcept(false) {
 // # global variable declaration.
 // glob ::= `let` decls `;`
 std::pair<std::vector<Decl*>, unsigned int> glob(unsigned int i) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Let") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Let) {
         auto [vec, itemp] = decls(i+1);
-        if (itemp < tokens.size() && tokens[itemp] == "Semicolon") return std::make_pair(vec, itemp+1);
-        else if (itemp < tokens.size()) throw fail(itemp);
+        if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::Semicolon) return std::make_pair(vec, itemp+1);
+        else if (tokens.has(itemp)) throw fail(itemp);
         else throw fail(-1);
     }
     throw fail(i);
@@ -808,18 +827,19 @@ std::pair<std::vector<Decl*>, unsigned int> glob(unsigned int i) {
 // # struct type definition.
 // typdef ::= `struct` id `{` decls `}`
 std::pair<Struct*, unsigned int> typedefn(unsigned int i) {
-    if (i >= tokens.size()) throw fail(i);
-    if (tokens[i] == "Struct") {
-        if (i + 1 < tokens.size() && tokens[i+1].substr(0, 2) == "Id") {
-            if (i + 2 < tokens.size() && tokens[i+2] == "OpenBrace") {
+    if (!tokens.has(i)) throw fail(i);
+    if (tokens[i].kind == TokenKind::Struct) {
+        if (tokens.has(i + 1) && tokens[i+1].kind == TokenKind::Id) {
+            if (tokens.has(i + 2) && tokens[i+2].kind == TokenKind::OpenBrace) {
+                SymbolId name = symbol(i+1); // before decls() moves the token window on
                 auto [vec, itemp] = decls(i+3);
-                if (itemp < tokens.size() && tokens[itemp] == "CloseBrace") {
-                    Struct* str = new Struct();
-                    str->name = tokens[i+1].substr(3, tokens[i+1].size()-4);
+                if (tokens.has(itemp) && tokens[itemp].kind == TokenKind::CloseBrace) {
+                    Struct* str = make<Struct>();
+                    str->name = name;
                     str->fields = vec;
                     return std::make_pair(str, itemp+1);
                 }
-                else if (itemp < tokens.size()) throw fail(itemp);
+                else if (tokens.has(itemp)) throw fail(itemp);
                 throw fail(-1);
             }
             else throw fail(i+2);
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../assign-1/symbol.cpp"
+using namespace std;
+
+#ifndef INSTRUCTIONS_CPP
+#define INSTRUCTIONS_CPP
+
+// The LIR as data. Lowering (the lower() methods in ast.cpp) emits
+// Instructions into BasicBlocks through a CodeBuilder, LIR::Function (lir.cpp)
+// keeps the blocks, and only printing turns any of it into text. A pass or a
+// backend works on these structures directly. The printers are templates over
+// the output, so the same code prints to an ostream or to a Writer.
+namespace LIR {
+
+// A value an instruction reads or writes: a temporary _tN, a named variable
+// (local, parameter, global or function), an integer constant, or nothing (_)
+struct Operand {
+    enum class Kind : uint8_t { None, Temp, Var, Const };
+
+    Kind kind = Kind::None;
+    uint32_t temp = 0;  // Temp: N in _tN
+    SymbolId var;       // Var
+    int32_t value = 0;  // Const
+
+    template<class Out>
+    friend Out& operator<<(Out& os, const Operand& o) {
+        switch (o.kind) {
+            case Kind::None: os << "_"; break;
+            case Kind::Temp: os << "_t" << o.temp; break;
+            case Kind::Var: os << o.var; break;
+            case Kind::Const: os << o.value; break;
+        }
+        return os;
+    }
+};
+
+inline Operand none() { return Operand(); }
+inline Operand temp(uint32_t n) {
+    Operand o;
+    o.kind = Operand::Kind::Temp;
+    o.temp = n;
+    return o;
+}
+inline Operand var(SymbolId name) {
+    Operand o;
+    o.kind = Operand::Kind::Var;
+    o.var = name;
+    return o;
+}
+inline Operand constant(int32_t n) {
+    Operand o;
+    o.kind = Operand::Kind::Const;
+    o.value = n;
+    return o;
+}
+
+// Unknown is what lowering emits for a statement it can't lower (a break
+// outside a loop); it prints as ?.
+enum class Opcode : uint8_t {
+    Alloc, Copy, Load, Store, Gep, Gfp, Arith, Cmp,
+    CallExt, CallDirect, CallIndirect, Jump, Branch, Ret, Unknown
+};
+
+// The operator of an Arith (add to div) or a Cmp (eq to gte)
+enum class Operator : uint8_t { Add, Sub, Mul, Div, Eq, Neq, Lt, Lte, Gt, Gte };
+
+inline const char* operatorName(Operator op) {
+    static const char* const names[] = { "add", "sub", "mul", "div", "eq", "neq", "lt", "lte", "gt", "gte" };
+    return names[static_cast<int>(op)];
+}
+
+// Labels are numbered from 1 within a function; 0 is the entry block. Printed,
+// a LabelName is entry or lblN.
+struct LabelName {
+    uint32_t label;
+
+    template<class Out>
+    friend Out& operator<<(Out& os, LabelName l) {
+        if (l.label == 0) os << "entry";
+        else os << "lbl" << l.label;
+        return os;
+    }
+};
+
+// Whether label a's name sorts before label b's: entry first, then lblN in the
+// order of the spelling of N
+inline bool labelBefore(uint32_t a, uint32_t b) {
+    if (a == 0 || b == 0) return a == 0 && b != 0;
+    char x[10], y[10];
+    char* x_end = to_chars(x, x + 10, a).ptr;
+    char* y_end = to_chars(y, y + 10, b).ptr;
+    return lexicographical_compare(x, x_end, y, y_end);
+}
+
+// One LIR instruction. Which fields are used depends on op:
+//   Alloc(dst, a)          Copy(dst, a)         Load(dst, a)       Store(dst, a)
+//   Gep(dst, a, b)         Gfp(dst, a, field)   Arith/Cmp(dst, aop, a, b)
+//   CallExt(dst, a, args)  CallDirect/CallIndirect(dst, a, args, label)
+//   Jump(label)            Branch(a, label, other)                 Ret(a)
+// where a call's label is the block it returns to. Store's dst is the pointer
+// stored through.
+struct Instruction {
+    Opcode op;
+    Operator aop = Operator::Add;
+    Operand dst, a, b;
+    SymbolId field;
+    uint32_t label = 0, other = 0;
+    vector<Operand> args;
+
+    explicit Instruction(Opcode op) : op(op) {}
+
+    // Ends its block: nothing after it in the block can run
+    bool isTerminator() const {
+        return op == Opcode::Jump || op == Opcode::Branch || op == Opcode::Ret
+            || op == Opcode::CallDirect || op == Opcode::CallIndirect;
+    }
+
+    template<class Out>
+    friend Out& operator<<(Out& os, const Instruction& i) {
+        auto printArgs = [&os, &i]() {
+            os << "[";
+            for (size_t k = 0; k < i.args.size(); k++) {
+                os << i.args[k];
+                if (k != i.args.size() - 1) os << ", ";
+            }
+            os << "]";
+        };
+        switch (i.op) {
+            case Opcode::Alloc: os << "Alloc(" << i.dst << ", " << i.a << ")"; break;
+            case Opcode::Copy: os << "Copy(" << i.dst << ", " << i.a << ")"; break;
+            case Opcode::Load: os << "Load(" << i.dst << ", " << i.a << ")"; break;
+            case Opcode::Store: os << "Store(" << i.dst << ", " << i.a << ")"; break;
+            case Opcode::Gep: os << "Gep(" << i.dst << ", " << i.a << ", " << i.b << ")"; break;
+            case Opcode::Gfp: os << "Gfp(" << i.dst << ", " << i.a << ", " << i.field << ")"; break;
+            case Opcode::Arith: os << "Arith(" << i.dst << ", " << operatorName(i.aop) << ", " << i.a << ", " << i.b << ")"; break;
+            case Opcode::Cmp: os << "Cmp(" << i.dst << ", " << operatorName(i.aop) << ", " << i.a << ", " << i.b << ")"; break;
+            case Opcode::CallExt:
+                os << "CallExt(" << i.dst << ", " << i.a << ", ";
+                printArgs();
+                os << ")";
+                break;
+            case Opcode::CallDirect:
+            case Opcode::CallIndirect:
+                os << (i.op == Opcode::CallDirect ? "CallDirect(" : "CallIndirect(") << i.dst << ", " << i.a << ", ";
+                printArgs();
+                os << ", " << LabelName{ i.label } << ")";
+                break;
+            case Opcode::Jump: os << "Jump(" << LabelName{ i.label } << ")"; break;
+            case Opcode::Branch: os << "Branch(" << i.a << ", " << LabelName{ i.label } << ", " << LabelName{ i.other } << ")"; break;
+            case Opcode::Ret: os << "Ret(" << i.a << ")"; break;
+            case Opcode::Unknown: os << "?"; break;
+        }
+        return os;
+    }
+};
+
+inline Instruction Alloc(Operand dst, Operand amount) {
+    Instruction i(Opcode::Alloc);
+    i.dst = dst;
+    i.a = amount;
+    return i;
+}
+inline Instruction Copy(Operand dst, Operand src) {
+    Instruction i(Opcode::Copy);
+    i.dst = dst;
+    i.a = src;
+    return i;
+}
+inline Instruction Load(Operand dst, Operand ptr) {
+    Instruction i(Opcode::Load);
+    i.dst = dst;
+    i.a = ptr;
+    return i;
+}
+inline Instruction Store(Operand ptr, Operand src) {
+    Instruction i(Opcode::Store);
+    i.dst = ptr;
+    i.a = src;
+    return i;
+}
+inline Instruction Gep(Operand dst, Operand ptr, Operand index) {
+    Instruction i(Opcode::Gep);
+    i.dst = dst;
+    i.a = ptr;
+    i.b = index;
+    return i;
+}
+inline Instruction Gfp(Operand dst, Operand ptr, SymbolId field) {
+    Instruction i(Opcode::Gfp);
+    i.dst = dst;
+    i.a = ptr;
+    i.field = field;
+    return i;
+}
+// Arith for add to div, Cmp for the comparisons
+inline Instruction Arith(Operand dst, Operator op, Operand left, Operand right) {
+    Instruction i(op <= Operator::Div ? Opcode::Arith : Opcode::Cmp);
+    i.aop = op;
+    i.dst = dst;
+    i.a = left;
+    i.b = right;
+    return i;
+}
+inline Instruction CallExt(Operand dst, Operand callee, vector<Operand> args) {
+    Instruction i(Opcode::CallExt);
+    i.dst = dst;
+    i.a = callee;
+    i.args = move(args);
+    return i;
+}
+inline Instruction CallDirect(Operand dst, Operand callee, vector<Operand> args, uint32_t next) {
+    Instruction i(Opcode::CallDirect);
+    i.dst = dst;
+    i.a = callee;
+    i.args = move(args);
+    i.label = next;
+    return i;
+}
+inline Instruction CallIndirect(Operand dst, Operand callee, vector<Operand> args, uint32_t next) {
+    Instruction i(Opcode::CallIndirect);
+    i.dst = dst;
+    i.a = callee;
+    i.args = move(args);
+    i.label = next;
+    return i;
+}
+inline Instruction Jump(uint32_t target) {
+    Instruction i(Opcode::Jump);
+    i.label = target;
+    return i;
+}
+inline Instruction Branch(Operand guard, uint32_t tt, uint32_t ff) {
+    Instruction i(Opcode::Branch);
+    i.a = guard;
+    i.label = tt;
+    i.other = ff;
+    return i;
+}
+inline Instruction Ret(Operand value) {
+    Instruction i(Opcode::Ret);
+    i.a = value;
+    return i;
+}
+inline Instruction Unknown() { return Instruction(Opcode::Unknown); }
+
+// A straight-line run of instructions, entered only at the top. dead counts the
+// instructions lowering emitted after the block's terminator, which are dropped;
+// the text format still shows a blank line for each.
+struct BasicBlock {
+    uint32_t label = 0;
+    vector<Instruction> instrs;
+    unsigned int dead = 0;
+};
+
+// Where lowering emits a function's code, building its control flow graph as
+// it goes: label() starts a new block, and an instruction emitted after the
+// current block's terminator can't run, so it is counted as dead rather than
+// kept.
+struct CodeBuilder {
+    vector<BasicBlock> blocks; // entry first, then in the order started
+    bool terminated = false;
+
+    CodeBuilder() : blocks(1) {}
+
+    void emit(Instruction instr) {
+        if (terminated) {
+            blocks.back().dead++;
+            return;
+        }
+        terminated = instr.isTerminator();
+        blocks.back().instrs.push_back(move(instr));
+    }
+    void label(uint32_t label) {
+        blocks.emplace_back();
+        blocks.back().label = label;
+        terminated = false;
+    }
+};
+
+}
+
+#endif
@@ -1,8 +1,16 @@
+#include <algorithm>
+#include <charconv>
 #include <typeinfo>
-#include <sstream>
+#include <map>
+#include <string_view>
+#include <optional>
+#include <unordered_set>
 #include <iostream>
 
 #include "ast.cpp"
+#include "instructions.cpp"
+#include "work_pool.cpp"
+#include "writer.cpp"
 using namespace std;
 
 namespace LIR {
@@ -10,149 +18,221 @@ namespace LIR {
     // // these are declared in main.cpp
     extern Gamma globals_map; // stores globals, externs, and functions. Used unless you call another function, in which case you do locals_map[functions_name]
     extern Delta delta; // struct name to (struct decl to type)
-    // extern unordered_map<string, Gamma> locals_map; // function name to its locals (params and locals) with global included
-    extern unordered_map<string, ParamsReturnVal> functions_map; // all functions to their funcInfo
-    extern unordered_map<string, FunctionsInfo> struct_functions_map; // struct name to (struct decl to funcInfo)
+    // extern unordered_map<SymbolId, Gamma> locals_map; // function name to its locals (params and locals) with global included
+    extern unordered_map<SymbolId, ParamsReturnVal> functions_map; // all functions to their funcInfo
+    extern unordered_map<SymbolId, FunctionsInfo> struct_functions_map; // struct name to (struct decl to funcInfo)
+
+    // Entries of a SymbolId-keyed map in the order of their names, which is the
+    // order the LIR lists them in
+    template<class Map>
+    vector<const typename Map::value_type*> byName(const Map& m) {
+        vector<const typename Map::value_type*> entries;
+        for (const auto& entry: m) entries.push_back(&entry);
+        sort(entries.begin(), entries.end(), [](auto* a, auto* b) { return a->first.str() < b->first.str(); });
+        return entries;
+    }
     
+    // The numbers 1 to n in the order of their decimal spellings: 1, 10, 100,
+    // 11, ..., 2, 20, ... That is the order of the temporaries' names.
+    inline vector<uint32_t> lexicographic(uint32_t n) {
+        vector<uint32_t> order;
+        order.reserve(n);
+        uint64_t k = 1;
+        for (uint32_t i = 0; i < n; i++) {
+            order.push_back(static_cast<uint32_t>(k));
+            if (k * 10 <= n) k *= 10;
+            else {
+                while (k % 10 == 9 || k + 1 > n) k /= 10;
+                k++;
+            }
+        }
+        return order;
+    }
+
+    // A lowered function. Printed, it reads
+    //   Function name(params) -> ret {
+    //     Locals
+    //       <each local and temporary> : <type>
+    //
+    //     entry:
+    //       ...
+    //   }
+    // with the locals and temporaries in the order of their names, and the
+    // blocks in the order of their labels' names.
     struct Function {
-        AST::Function* func;
-        vector<string> tempsToType; // stores which type each temp has, ie if _t2 is type Int, Int will be in tempsToType[1]
-        unsigned int numLabels = 0;
-        unsigned int prevWhileHdr = 0;
-        unsigned int prevWhileEnd = 0;
-        map<string, string> extern_map;
-        map<string, string> function_map;
-        unordered_map<string, Type*> gamma;
-        Function(AST::Function* func, map<string, string> extern_map, map<string, string> function_map, Gamma& gamma) : func(func), extern_map(extern_map), function_map(function_map), gamma(gamma) {}
-        
-        string lowerFunc() {
-            // loweredStmts takes a local declaration, ie let x: int = 3;
-            // then creates an AST::Assign with Lval x and Rhs 3
-            // then lowers this Stmt and stores the resulting instructions
-            // also stores following functions stmts to lowered form
-            map<string, string> localsMap;
-            vector<string> loweredStmts;
+        SymbolId name;
+        vector<pair<SymbolId, const CanonType*>> params;
+        const CanonType* ret = nullptr;
+        vector<pair<SymbolId, const CanonType*>> locals; // in the order of their names
+        vector<const CanonType*> temps; // _tN has type temps[N-1]
+        vector<BasicBlock> blocks;      // entry first, then in the order started
+
+        // An empty function, to be filled in by a reader of the binary format
+        explicit Function(SymbolId name) : name(name) {}
+        Function(AST::Function* func, const unordered_map<SymbolId, const CanonType*>& extern_map, const unordered_set<SymbolId>& function_names, const Gamma& gamma) : name(func->name) {
+            vector<const CanonType*> tempsToType; // stores which type each temp has, ie if _t2 is type Int, Int will be in tempsToType[1]
+            unsigned int numLabels = 0;
+            unsigned int prevWhileHdr = 0;
+            unsigned int prevWhileEnd = 0;
+            CodeBuilder code;
+            // Each local declaration, ie let x: int = 3;
+            // creates an AST::Assign with Lval x and Rhs 3
+            // and lowers this Stmt, then the function's stmts follow
             for (auto& pair: func->locals) {
-                localsMap[pair.first->name] = pair.first->type->toLIRType();
-                if (typeid(*(pair.second)) == typeid(AST::AnyExp)) { continue; }
+                locals.emplace_back(pair.first->name, pair.first->type->canon);
+                if (AST::isa<AST::AnyExp>(pair.second)) { continue; }
                 else {
-                    AST::RhsExp* rhs = new RhsExp();
-                    rhs->exp = pair.second;
-                    AST::LvalId* lvalid = new LvalId();
-                    lvalid->name = pair.first->name;
-                    AST::Assign* assign = new Assign();
-                    assign->lhs = lvalid;
-                    assign->rhs = rhs;
-                    loweredStmts.push_back(assign->lower(tempsToType, numLabels, gamma, func, prevWhileHdr, prevWhileEnd, extern_map, function_map));
+                    AST::RhsExp rhs;
+                    rhs.exp = pair.second;
+                    AST::LvalId lvalid;
+                    lvalid.name = pair.first->name;
+                    AST::Assign assign;
+                    assign.lhs = &lvalid;
+                    assign.rhs = &rhs;
+                    assign.lower(code, tempsToType, numLabels, gamma, func, prevWhileHdr, prevWhileEnd, extern_map, function_names);
                 }
             }
-            for (AST::Stmt* stmt: func->stmts) loweredStmts.push_back(stmt->lower(tempsToType, numLabels, gamma, func, prevWhileHdr, prevWhileEnd, extern_map, function_map));
-            
-            string res = "Function " + func->name + "(";
-            for (unsigned int i = 0; i < func->params.size(); i++) {
-                res +=  func->params[i]->name + ":" + func->params[i]->type->toLIRType();
-                if (i != func->params.size() - 1) res += ", ";
-            }
-            res += ") -> " + func->rettyp->toLIRType() + " {\n  Locals\n";
-            for (unsigned int i = 0; i < tempsToType.size(); i++) {
-                localsMap["_t" + to_string(i+1)] = tempsToType[i];
-            }
-            for (auto& pair: localsMap) {
-                res += "    " + pair.first + " : " + pair.second + "\n";
-            }
+            for (AST::Stmt* stmt: func->stmts) stmt->lower(code, tempsToType, numLabels, gamma, func, prevWhileHdr, prevWhileEnd, extern_map, function_names);
 
-            string lowered = "";
-            for (string str: loweredStmts) lowered += str;
-            
-            // this is the CFG construction
-            istringstream iss(lowered);
-            bool terminalBefore = false;
-            string actual = "";
-            string line;
-            while(getline(iss, line)) {
-                actual += "\n";
-                if (line.substr(0, 5) == "  lbl") terminalBefore = false;
-                if (terminalBefore) continue;
-                actual += line;
-                if (line.substr(0, 8) == "    Jump" || line.substr(0, 7) == "    Ret") terminalBefore = true;
-            }
-            
-            map<string, string> lblToInstructions;
-            string prevLabel = "entry";
-            string chunk = "";
-            istringstream iss2(actual);
-            while (getline(iss2, line)) {
-                if (line.substr(0, 5) == "  lbl") {
-                    lblToInstructions[prevLabel] = chunk;
-                    chunk = "";
-                    prevLabel = line.substr(2, line.size()-3);
-                }
-                else chunk += "\n" + line;
-            }
-            if (chunk != "") lblToInstructions[prevLabel] = chunk + "\n";
+            for (AST::Decl* param: func->params) params.emplace_back(param->name, param->type->canon);
+            ret = func->rettyp->canon;
+            // a local declared twice is listed once, with its last type
+            stable_sort(locals.begin(), locals.end(), [](auto& a, auto& b) { return a.first.str() < b.first.str(); });
+            auto last = locals.begin();
+            for (auto it = locals.begin(); it != locals.end(); ++it) {
+                if (next(it) == locals.end() || next(it)->first != it->first) *last++ = *it;
+            }
+            locals.erase(last, locals.end());
+            temps = move(tempsToType);
+            blocks = move(code.blocks);
+        }
 
-            res += "\n";
-            for (auto& pair: lblToInstructions) {
-                res += "  " + pair.first + ":";
-                res += pair.second;
-                res += "\n";
-            }
-            
-            res += "}";
+        size_t size() const {
+            size_t n = 0;
+            for (const BasicBlock& block: blocks) n += block.instrs.size();
+            return n;
+        }
 
-            return res;
+        // The text format keeps the blank lines the string-based lowering used to
+        // leave: one after "entry:", one for each dead instruction but a last one
+        // ending the function, and one after every block. An empty block ending
+        // the function isn't printed.
+        void print(Writer& os) const {
+            os << "Function " << name << "(";
+            for (unsigned int i = 0; i < params.size(); i++) {
+                os << params[i].first << ":" << params[i].second->lir;
+                if (i != params.size() - 1) os << ", ";
+            }
+            os << ") -> " << ret->lir << " {\n  Locals\n";
+            // merges the locals with the temporaries, both in name order; a
+            // local that has a temporary's name is hidden by it
+            vector<uint32_t> order = lexicographic(static_cast<uint32_t>(temps.size()));
+            char buffer[16] = "_t";
+            size_t l = 0, t = 0;
+            while (l < locals.size() || t < order.size()) {
+                string_view temp;
+                if (t < order.size()) temp = string_view(buffer, to_chars(buffer + 2, end(buffer), order[t]).ptr - buffer);
+                if (t == order.size() || (l < locals.size() && locals[l].first.str() < temp)) {
+                    os << "    " << locals[l].first << " : " << locals[l].second->lir << "\n";
+                    l++;
+                    continue;
+                }
+                if (l < locals.size() && locals[l].first.str() == temp) l++;
+                os << "    " << temp << " : " << temps[order[t] - 1]->lir << "\n";
+                t++;
+            }
+            os << "\n";
+            vector<const BasicBlock*> sorted;
+            for (const BasicBlock& block: blocks) {
+                bool last = &block == &blocks.back();
+                if (!(last && block.instrs.empty() && block.dead == 0)) sorted.push_back(&block);
+            }
+            sort(sorted.begin(), sorted.end(), [](auto* a, auto* b) { return labelBefore(a->label, b->label); });
+            for (const BasicBlock* block: sorted) {
+                bool last = block == &blocks.back();
+                os << "  " << LabelName{ block->label } << ":";
+                if (block->label == 0) os << "\n";
+                for (const Instruction& instr: block->instrs) {
+                    os << "\n" << (instr.op == Opcode::Unknown ? "" : "    ") << instr;
+                }
+                unsigned int blank = (last && block->dead > 0) ? block->dead - 1 : block->dead;
+                for (unsigned int i = 0; i < blank; i++) os << "\n";
+                os << "\n\n";
+            }
+            os << "}";
         }
     };
 
     struct Program {
-        map<string, string> global_map;
-        map<string, map<string, string>> struct_map;
-        map<string, string> extern_map;
-        map<string, string> function_map;
-        unordered_map<string, Gamma> locals_map;
+        map<string, const CanonType*> global_map;
+        map<string, map<string, const CanonType*>> struct_map;
+        unordered_map<SymbolId, const CanonType*> extern_map;
+        unordered_map<SymbolId, Function> function_map;
 
-        Program(AST::Program* prog, unordered_map<string, Gamma>& locals_map) : locals_map(locals_map) {
+        // Functions are lowered on `threads` threads. Each has its own
+        // temporaries and labels and only reads the tables shared with the
+        // others, so no lowering waits on another.
+        Program(AST::Program* prog, unordered_map<SymbolId, Gamma>& locals_map, unsigned threads = 1) {
             for (AST::Decl* decl: prog->globals) { 
-                global_map[decl->name] = decl->type->toLIRType();
+                global_map[decl->name.str()] = decl->type->canon;
             }
             for (AST::Function* func: prog->functions) {
-                if (func->name != "main") global_map[func->name] = "Ptr(" + func->toLIRType() + ")";
+                if (func->name != SymbolTable::Main) global_map[func->name.str()] = types().ptr(func->canonical());
             }
             for (AST::Struct* str: prog->structs) {
-                map<string, string> temp_map;
+                map<string, const CanonType*> temp_map;
                 for (AST::Decl* decl: str->fields) {
-                    temp_map[decl->name] = decl->type->toLIRType();
+                    temp_map[decl->name.str()] = decl->type->canon;
                 }
-                struct_map[str->name] = temp_map;
+                struct_map[str->name.str()] = temp_map;
             }
             for (AST::Decl* decl: prog->externs) {
-                extern_map[decl->name] = decl->type->toLIRType();
+                extern_map[decl->name] = decl->type->canon;
             }
+            // every function is known before any is lowered, so calls to all
+            // of them, defined earlier or later, are CallDirect
+            unordered_set<SymbolId> function_names;
+            vector<const Gamma*> scopes; // looked up here: operator[] may insert
             for (AST::Function* func: prog->functions) {
-                Function helper(func, extern_map, function_map, locals_map[func->name]);
-                function_map[func->name] = helper.lowerFunc();
+                function_names.insert(func->name);
+                scopes.push_back(&locals_map[func->name]);
+            }
+            vector<optional<Function>> lowered(prog->functions.size());
+            WorkPool(threads).run(lowered.size(), [&](size_t i, unsigned) {
+                lowered[i].emplace(prog->functions[i], extern_map, function_names, *scopes[i]);
+            });
+            function_map.reserve(lowered.size());
+            for (size_t i = 0; i < lowered.size(); i++) {
+                function_map.insert_or_assign(prog->functions[i]->name, move(*lowered[i]));
             }
         }
-        void print() {
+        // Writes the program to out as it goes, one function at a time, so the
+        // text of the whole module is never held in memory
+        void print(Writer& out) const {
             for (const auto& pair: struct_map) {
-                cout << "Struct " << pair.first << "\n";
+                out << "Struct " << pair.first << "\n";
                 for (const auto& pair1: pair.second) {
-                    cout << "  " << pair1.first << " : " << pair1.second << "\n";
+                    out << "  " << pair1.first << " : " << pair1.second->lir << "\n";
                 }
-                cout << "\n";
+                out << "\n";
             }
-            cout << "Externs\n";
-            for (const auto& pair: extern_map) {
-                cout << "  " << pair.first << " : " << pair.second << "\n";
+            out << "Externs\n";
+            for (const auto* pair: byName(extern_map)) {
+                out << "  " << pair->first << " : " << pair->second->lir << "\n";
             }
-            cout << "\nGlobals\n";
+            out << "\nGlobals\n";
             for (const auto& pair: global_map) {
-                cout << "  " << pair.first << " : " << pair.second << "\n";
+                out << "  " << pair.first << " : " << pair.second->lir << "\n";
             }
-            cout << "\n";
-            for (const auto& pair: function_map) {
-                cout << pair.second << "\n\n"; // second contains the full string of the function lowering
+            out << "\n";
+            for (const auto* pair: byName(function_map)) {
+                pair->second.print(out);
+                out << "\n\n";
             }
         }
+        void print() const {
+            Writer out(stdout);
+            print(out);
+        }
     };
 }
\ No newline at end of file
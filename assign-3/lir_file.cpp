@@ -0,0 +1,449 @@
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "lir.cpp"
+#include "writer.cpp"
+using namespace std;
+
+#ifndef LIR_FILE_CPP
+#define LIR_FILE_CPP
+
+// Binary LIR, for handing a lowered module to an optimizer or a backend run as
+// a separate step without printing it and parsing the text back:
+//   header        "CFLR", u32 version, then the u32 count of each section
+//   strings       { u32 offset, u32 length } into the characters
+//   characters    every name and type spelling, each stored once; padded to 4 bytes
+//   types         { u8 tag, u8 pad[3], u32 name, u32 ref, u32 lir, u32 firstParam, u32 paramCount }
+//   typeParams    u32 type
+//   structs       { u32 name, u32 firstField, u32 fieldCount }
+//   fields        { u32 name, u32 type }
+//   externs       { u32 name, u32 type }
+//   globals       { u32 name, u32 type }
+//   functions     { u32 name, u32 ret, then u32 first, u32 count of its params,
+//                   locals, temps and blocks }
+//   params        { u32 name, u32 type }
+//   locals        { u32 name, u32 type }
+//   temps         u32 type, _tN of a function being its (N-1)th
+//   blocks        { u32 label, u32 dead, u32 firstInstr, u32 instrCount }
+//   instructions  { u8 op, u8 aop, u8 pad[2], Operand dst, a, b, u32 field,
+//                   u32 label, u32 other, u32 firstArg, u32 argCount }
+//   args          Operand
+// An Operand is { u32 kind, u32 value }: a temporary's number, a variable's name
+// or a constant's bits. Names and spellings index strings, types index types
+// (which come after the types they refer to), and None marks a field a record
+// doesn't use. Sections are in print order: structs and their fields, externs,
+// globals, functions and locals by name; a function's blocks are in the order
+// they were started. Every record is 4-byte aligned and in the writer's byte
+// order. The tag, op, aop and kind values are those of the enums, so reordering
+// one means bumping the version.
+namespace lir_file {
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t strings, characterBytes, types, typeParams, structs, fields, externs, globals;
+    uint32_t functions, params, locals, temps, blocks, instructions, args;
+};
+struct String { uint32_t offset, length; };
+struct Type {
+    uint8_t tag;
+    uint8_t pad[3];
+    uint32_t name, ref, lir, firstParam, paramCount;
+};
+struct Struct { uint32_t name, firstField, fieldCount; };
+struct Entry { uint32_t name, type; };
+struct Function {
+    uint32_t name, ret;
+    uint32_t firstParam, paramCount, firstLocal, localCount;
+    uint32_t firstTemp, tempCount, firstBlock, blockCount;
+};
+struct Block { uint32_t label, dead, firstInstr, instrCount; };
+struct Operand { uint32_t kind, value; };
+struct Instruction {
+    uint8_t op, aop;
+    uint8_t pad[2];
+    Operand dst, a, b;
+    uint32_t field, label, other, firstArg, argCount;
+};
+static_assert(sizeof(Header) == 68 && sizeof(Type) == 24 && sizeof(Function) == 40 && sizeof(Instruction) == 48, "LIR file layout");
+
+constexpr char magic[4] = { 'C', 'F', 'L', 'R' };
+constexpr uint32_t version = 1;
+constexpr uint32_t None = ~uint32_t(0);
+
+inline bool isBinary(string_view data) {
+    return data.size() >= sizeof(Header) && memcmp(data.data(), magic, sizeof(magic)) == 0;
+}
+
+}
+
+// Turns a lowered Program into the binary format. The sections are gathered in
+// memory and written out together by write().
+struct LirFileWriter {
+    lir_file::Header header = {};
+    vector<lir_file::String> strings;
+    string characters;
+    unordered_map<string_view, uint32_t> stringIds; // views of the program's names
+    vector<lir_file::Type> types;
+    vector<uint32_t> typeParams;
+    unordered_map<const CanonType*, uint32_t> typeIds;
+    vector<lir_file::Struct> structs;
+    vector<lir_file::Entry> fields, externs, globals, params, locals;
+    vector<lir_file::Function> functions;
+    vector<uint32_t> temps;
+    vector<lir_file::Block> blocks;
+    vector<lir_file::Instruction> instructions;
+    vector<lir_file::Operand> args;
+
+    explicit LirFileWriter(const LIR::Program& program) {
+        for (const auto& [name, members]: program.struct_map) {
+            structs.push_back({ stringId(name), static_cast<uint32_t>(fields.size()), static_cast<uint32_t>(members.size()) });
+            for (const auto& [field, type]: members) fields.push_back({ stringId(field), typeId(type) });
+        }
+        for (const auto* pair: LIR::byName(program.extern_map)) externs.push_back({ stringId(pair->first.str()), typeId(pair->second) });
+        for (const auto& [name, type]: program.global_map) globals.push_back({ stringId(name), typeId(type) });
+        for (const auto* pair: LIR::byName(program.function_map)) add(pair->second);
+    }
+
+    void add(const LIR::Function& f) {
+        lir_file::Function r;
+        r.name = stringId(f.name.str());
+        r.ret = typeId(f.ret);
+        r.firstParam = static_cast<uint32_t>(params.size());
+        r.paramCount = static_cast<uint32_t>(f.params.size());
+        for (const auto& [name, type]: f.params) params.push_back({ stringId(name.str()), typeId(type) });
+        r.firstLocal = static_cast<uint32_t>(locals.size());
+        r.localCount = static_cast<uint32_t>(f.locals.size());
+        for (const auto& [name, type]: f.locals) locals.push_back({ stringId(name.str()), typeId(type) });
+        r.firstTemp = static_cast<uint32_t>(temps.size());
+        r.tempCount = static_cast<uint32_t>(f.temps.size());
+        for (const CanonType* t: f.temps) temps.push_back(typeId(t));
+        r.firstBlock = static_cast<uint32_t>(blocks.size());
+        r.blockCount = static_cast<uint32_t>(f.blocks.size());
+        for (const LIR::BasicBlock& block: f.blocks) {
+            blocks.push_back({ block.label, block.dead, static_cast<uint32_t>(instructions.size()), static_cast<uint32_t>(block.instrs.size()) });
+            for (const LIR::Instruction& instr: block.instrs) add(instr);
+        }
+        functions.push_back(r);
+    }
+
+    void add(const LIR::Instruction& instr) {
+        lir_file::Instruction r = {};
+        r.op = static_cast<uint8_t>(instr.op);
+        r.aop = static_cast<uint8_t>(instr.aop);
+        r.dst = operand(instr.dst);
+        r.a = operand(instr.a);
+        r.b = operand(instr.b);
+        r.field = instr.op == LIR::Opcode::Gfp ? stringId(instr.field.str()) : lir_file::None;
+        r.label = instr.label;
+        r.other = instr.other;
+        r.firstArg = static_cast<uint32_t>(args.size());
+        r.argCount = static_cast<uint32_t>(instr.args.size());
+        for (const LIR::Operand& arg: instr.args) args.push_back(operand(arg));
+        instructions.push_back(r);
+    }
+
+    lir_file::Operand operand(const LIR::Operand& o) {
+        switch (o.kind) {
+            case LIR::Operand::Kind::None: return { static_cast<uint32_t>(o.kind), 0 };
+            case LIR::Operand::Kind::Temp: return { static_cast<uint32_t>(o.kind), o.temp };
+            case LIR::Operand::Kind::Var: return { static_cast<uint32_t>(o.kind), stringId(o.var.str()) };
+            case LIR::Operand::Kind::Const: return { static_cast<uint32_t>(o.kind), static_cast<uint32_t>(o.value) };
+        }
+        return { 0, 0 };
+    }
+
+    // The index of text in the string table; text must outlive the writer
+    uint32_t stringId(string_view text) {
+        auto [it, inserted] = stringIds.try_emplace(text, static_cast<uint32_t>(strings.size()));
+        if (inserted) {
+            strings.push_back({ static_cast<uint32_t>(characters.size()), static_cast<uint32_t>(text.size()) });
+            characters += text;
+        }
+        return it->second;
+    }
+
+    // The index of t in the type table, adding it (after the types it refers to)
+    // if it isn't there yet
+    uint32_t typeId(const CanonType* t) {
+        auto it = typeIds.find(t);
+        if (it != typeIds.end()) return it->second;
+        lir_file::Type r = {};
+        r.tag = static_cast<uint8_t>(t->tag);
+        r.name = t->isStruct() ? stringId(t->name.str()) : lir_file::None;
+        r.ref = t->ref ? typeId(t->ref) : lir_file::None;
+        vector<uint32_t> ps;
+        for (const CanonType* p: t->params) ps.push_back(typeId(p));
+        r.lir = stringId(t->lir);
+        r.firstParam = static_cast<uint32_t>(typeParams.size());
+        r.paramCount = static_cast<uint32_t>(ps.size());
+        typeParams.insert(typeParams.end(), ps.begin(), ps.end());
+        types.push_back(r);
+        return typeIds[t] = static_cast<uint32_t>(types.size() - 1);
+    }
+
+    template<class T>
+    static void put(Writer& out, const vector<T>& records) {
+        out << string_view(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+    }
+
+    void write(Writer& out) {
+        memcpy(header.magic, lir_file::magic, sizeof(header.magic));
+        header.version = lir_file::version;
+        characters.resize((characters.size() + 3) / 4 * 4, '\0');
+        header.strings = static_cast<uint32_t>(strings.size());
+        header.characterBytes = static_cast<uint32_t>(characters.size());
+        header.types = static_cast<uint32_t>(types.size());
+        header.typeParams = static_cast<uint32_t>(typeParams.size());
+        header.structs = static_cast<uint32_t>(structs.size());
+        header.fields = static_cast<uint32_t>(fields.size());
+        header.externs = static_cast<uint32_t>(externs.size());
+        header.globals = static_cast<uint32_t>(globals.size());
+        header.functions = static_cast<uint32_t>(functions.size());
+        header.params = static_cast<uint32_t>(params.size());
+        header.locals = static_cast<uint32_t>(locals.size());
+        header.temps = static_cast<uint32_t>(temps.size());
+        header.blocks = static_cast<uint32_t>(blocks.size());
+        header.instructions = static_cast<uint32_t>(instructions.size());
+        header.args = static_cast<uint32_t>(args.size());
+        out << string_view(reinterpret_cast<const char*>(&header), sizeof(header));
+        put(out, strings);
+        out << characters;
+        put(out, types);
+        put(out, typeParams);
+        put(out, structs);
+        put(out, fields);
+        put(out, externs);
+        put(out, globals);
+        put(out, functions);
+        put(out, params);
+        put(out, locals);
+        put(out, temps);
+        put(out, blocks);
+        put(out, instructions);
+        put(out, args);
+    }
+};
+
+// A binary LIR module read in place: the sections are arrays pointing into
+// data, which must outlive the LirFile and be 4-byte aligned (an mmapped
+// SourceFile is). Opening one checks that every section fits and that every
+// index in it is in range, and copies nothing. Throws runtime_error if data is
+// malformed.
+struct LirFile {
+    template<class T>
+    struct Section {
+        const T* records = nullptr;
+        uint32_t count = 0;
+
+        const T* begin() const { return records; }
+        const T* end() const { return records + count; }
+        uint32_t size() const { return count; }
+        const T& operator[](uint32_t i) const { return records[i]; }
+        // The count records starting at first, which must be in range
+        Section slice(uint32_t first, uint32_t n) const { return Section{ records + first, n }; }
+    };
+
+    lir_file::Header header;
+    Section<lir_file::String> strings;
+    const char* characters = nullptr;
+    Section<lir_file::Type> types;
+    Section<uint32_t> typeParams;
+    Section<lir_file::Struct> structs;
+    Section<lir_file::Entry> fields, externs, globals;
+    Section<lir_file::Function> functions;
+    Section<lir_file::Entry> params, locals;
+    Section<uint32_t> temps;
+    Section<lir_file::Block> blocks;
+    Section<lir_file::Instruction> instructions;
+    Section<lir_file::Operand> args;
+
+    explicit LirFile(string_view data) {
+        using namespace lir_file;
+        if (!isBinary(data)) throw runtime_error("not a binary LIR file");
+        if (reinterpret_cast<uintptr_t>(data.data()) % 4 != 0) throw runtime_error("misaligned LIR file");
+        memcpy(&header, data.data(), sizeof(header));
+        if (header.version != version) throw runtime_error("unsupported LIR file version " + to_string(header.version));
+        size_t at = sizeof(Header);
+        auto section = [&](auto& s, uint32_t count) {
+            using T = remove_reference_t<decltype(*s.records)>;
+            if ((data.size() - at) / sizeof(T) < count) throw runtime_error("truncated LIR file");
+            s.records = reinterpret_cast<const T*>(data.data() + at);
+            s.count = count;
+            at += size_t(count) * sizeof(T);
+        };
+        section(strings, header.strings);
+        if (data.size() - at < header.characterBytes || header.characterBytes % 4 != 0) throw runtime_error("truncated LIR file");
+        characters = data.data() + at;
+        at += header.characterBytes;
+        section(types, header.types);
+        section(typeParams, header.typeParams);
+        section(structs, header.structs);
+        section(fields, header.fields);
+        section(externs, header.externs);
+        section(globals, header.globals);
+        section(functions, header.functions);
+        section(params, header.params);
+        section(locals, header.locals);
+        section(temps, header.temps);
+        section(blocks, header.blocks);
+        section(instructions, header.instructions);
+        section(args, header.args);
+        check();
+    }
+
+    string_view str(uint32_t i) const { return string_view(characters + strings[i].offset, strings[i].length); }
+
+    // The text form of a type
+    string_view lir(uint32_t type) const { return str(types[type].lir); }
+
+    // Rebuilds function i as a LIR::Function, with its names interned and its
+    // types made canonical again, e.g. to run a pass over it or print it
+    LIR::Function function(uint32_t i, const vector<SymbolId>& names, const vector<const CanonType*>& canon) const {
+        const lir_file::Function& r = functions[i];
+        LIR::Function f(names[r.name]);
+        f.ret = canon[r.ret];
+        for (const lir_file::Entry& e: params.slice(r.firstParam, r.paramCount)) f.params.emplace_back(names[e.name], canon[e.type]);
+        for (const lir_file::Entry& e: locals.slice(r.firstLocal, r.localCount)) f.locals.emplace_back(names[e.name], canon[e.type]);
+        for (uint32_t t: temps.slice(r.firstTemp, r.tempCount)) f.temps.push_back(canon[t]);
+        for (const lir_file::Block& b: blocks.slice(r.firstBlock, r.blockCount)) {
+            LIR::BasicBlock& block = f.blocks.emplace_back();
+            block.label = b.label;
+            block.dead = b.dead;
+            for (const lir_file::Instruction& instr: instructions.slice(b.firstInstr, b.instrCount)) {
+                LIR::Instruction& decoded = block.instrs.emplace_back(static_cast<LIR::Opcode>(instr.op));
+                decoded.aop = static_cast<LIR::Operator>(instr.aop);
+                decoded.dst = operand(instr.dst, names);
+                decoded.a = operand(instr.a, names);
+                decoded.b = operand(instr.b, names);
+                if (instr.field != lir_file::None) decoded.field = names[instr.field];
+                decoded.label = instr.label;
+                decoded.other = instr.other;
+                for (const lir_file::Operand& arg: args.slice(instr.firstArg, instr.argCount)) decoded.args.push_back(operand(arg, names));
+            }
+        }
+        return f;
+    }
+
+    // Every string interned, by index
+    vector<SymbolId> names() const {
+        vector<SymbolId> ids;
+        ids.reserve(strings.size());
+        for (uint32_t i = 0; i < strings.size(); i++) ids.push_back(symbols().intern(str(i)));
+        return ids;
+    }
+
+    // Every type made canonical in types(), by index
+    vector<const CanonType*> canonicalTypes(const vector<SymbolId>& names) const {
+        vector<const CanonType*> canon;
+        canon.reserve(types.size());
+        for (const lir_file::Type& t: types) {
+            switch (static_cast<CanonType::Tag>(t.tag)) {
+                case CanonType::Tag::Int: canon.push_back(::types().integer()); break;
+                case CanonType::Tag::Any: canon.push_back(::types().any()); break;
+                case CanonType::Tag::Struct: canon.push_back(::types().structType(names[t.name])); break;
+                case CanonType::Tag::Ptr: canon.push_back(::types().ptr(canon[t.ref])); break;
+                case CanonType::Tag::Fn: {
+                    vector<const CanonType*> ps;
+                    for (uint32_t p: typeParams.slice(t.firstParam, t.paramCount)) ps.push_back(canon[p]);
+                    canon.push_back(::types().fn(ps, canon[t.ref]));
+                    break;
+                }
+            }
+        }
+        return canon;
+    }
+
+    // Writes the module as LIR::Program::print does, rebuilding one function
+    // at a time
+    void print(Writer& out) const {
+        vector<SymbolId> ids = names();
+        vector<const CanonType*> canon = canonicalTypes(ids);
+        for (const lir_file::Struct& s: structs) {
+            out << "Struct " << str(s.name) << "\n";
+            for (const lir_file::Entry& field: fields.slice(s.firstField, s.fieldCount)) {
+                out << "  " << str(field.name) << " : " << lir(field.type) << "\n";
+            }
+            out << "\n";
+        }
+        out << "Externs\n";
+        for (const lir_file::Entry& e: externs) out << "  " << str(e.name) << " : " << lir(e.type) << "\n";
+        out << "\nGlobals\n";
+        for (const lir_file::Entry& e: globals) out << "  " << str(e.name) << " : " << lir(e.type) << "\n";
+        out << "\n";
+        for (uint32_t i = 0; i < functions.size(); i++) {
+            function(i, ids, canon).print(out);
+            out << "\n\n";
+        }
+    }
+
+  private:
+    static LIR::Operand operand(const lir_file::Operand& o, const vector<SymbolId>& names) {
+        switch (static_cast<LIR::Operand::Kind>(o.kind)) {
+            case LIR::Operand::Kind::None: return LIR::none();
+            case LIR::Operand::Kind::Temp: return LIR::temp(o.value);
+            case LIR::Operand::Kind::Var: return LIR::var(names[o.value]);
+            case LIR::Operand::Kind::Const: return LIR::constant(static_cast<int32_t>(o.value));
+        }
+        return LIR::none();
+    }
+
+    // Every index in range, so that nothing read through the sections can go
+    // outside data
+    void check() const {
+        auto fail = [](const char* what) { throw runtime_error(string("bad LIR file: ") + what); };
+        auto inRange = [](uint32_t first, uint32_t count, uint32_t size) { return first <= size && count <= size - first; };
+        auto isString = [&](uint32_t s) { return s < strings.size(); };
+        for (const lir_file::String& s: strings) {
+            if (!inRange(s.offset, s.length, header.characterBytes)) fail("string");
+        }
+        for (uint32_t i = 0; i < types.size(); i++) {
+            const lir_file::Type& t = types[i];
+            if (t.tag > static_cast<uint8_t>(CanonType::Tag::Fn) || !isString(t.lir)) fail("type");
+            if (t.tag == static_cast<uint8_t>(CanonType::Tag::Struct) && !isString(t.name)) fail("type");
+            if ((t.tag == static_cast<uint8_t>(CanonType::Tag::Ptr) || t.tag == static_cast<uint8_t>(CanonType::Tag::Fn)) && t.ref >= i) fail("type");
+            if (!inRange(t.firstParam, t.paramCount, typeParams.size())) fail("type");
+            for (uint32_t p: typeParams.slice(t.firstParam, t.paramCount)) if (p >= i) fail("type");
+        }
+        auto checkEntries = [&](Section<lir_file::Entry> entries) {
+            for (const lir_file::Entry& e: entries) if (!isString(e.name) || e.type >= types.size()) fail("entry");
+        };
+        checkEntries(fields);
+        checkEntries(externs);
+        checkEntries(globals);
+        checkEntries(params);
+        checkEntries(locals);
+        for (const lir_file::Struct& s: structs) {
+            if (!isString(s.name) || !inRange(s.firstField, s.fieldCount, fields.size())) fail("struct");
+        }
+        for (uint32_t t: temps) if (t >= types.size()) fail("temp");
+        for (const lir_file::Function& f: functions) {
+            if (!isString(f.name) || f.ret >= types.size() || !inRange(f.firstParam, f.paramCount, params.size())
+                || !inRange(f.firstLocal, f.localCount, locals.size()) || !inRange(f.firstTemp, f.tempCount, temps.size())
+                || !inRange(f.firstBlock, f.blockCount, blocks.size())) fail("function");
+        }
+        for (const lir_file::Block& b: blocks) {
+            if (!inRange(b.firstInstr, b.instrCount, instructions.size())) fail("block");
+        }
+        auto checkOperand = [&](const lir_file::Operand& o) {
+            if (o.kind > static_cast<uint32_t>(LIR::Operand::Kind::Const)) fail("operand");
+            if (o.kind == static_cast<uint32_t>(LIR::Operand::Kind::Var) && !isString(o.value)) fail("operand");
+        };
+        for (const lir_file::Instruction& instr: instructions) {
+            if (instr.op > static_cast<uint8_t>(LIR::Opcode::Unknown) || instr.aop > static_cast<uint8_t>(LIR::Operator::Gte)) fail("instruction");
+            if (instr.field != lir_file::None && !isString(instr.field)) fail("instruction");
+            if (!inRange(instr.firstArg, instr.argCount, args.size())) fail("instruction");
+            checkOperand(instr.dst);
+            checkOperand(instr.a);
+            checkOperand(instr.b);
+        }
+        for (const lir_file::Operand& o: args) checkOperand(o);
+    }
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include "../assign-1/source.cpp"
+#include "lir_file.cpp"
+#include "maps.cpp"
+using namespace std;
+
+// lirdump: prints a binary LIR file (cflatc --emit=lirb) as the text LIR that
+// cflatc and `lower` print.
+//   lirdump [--time] <file>
+// --time reports how long opening the file took to stderr.
+int main(int argc, char** argv) {
+    bool time = false;
+    const char* path = nullptr;
+    bool usage = false;
+    for (int i = 1; i < argc; i++) {
+        string_view arg = argv[i];
+        if (arg == "--time") time = true;
+        else if (!path && (arg == "-" || arg[0] != '-')) path = argv[i];
+        else {
+            usage = true;
+            break;
+        }
+    }
+    if (usage || !path) {
+        cerr << "Usage: lirdump [--time] <file>\n";
+        return 1;
+    }
+    unique_ptr<SourceFile> source;
+    try {
+        source = make_unique<SourceFile>(path);
+    }
+    catch(const exception& e) {
+        cerr << "Invalid file\n";
+        return 1;
+    }
+    auto start = chrono::steady_clock::now();
+    unique_ptr<LirFile> file;
+    try {
+        file = make_unique<LirFile>(source->view());
+    }
+    catch(const exception& e) {
+        cerr << "Invalid LIR file: " << e.what() << "\n";
+        return 1;
+    }
+    if (time) {
+        cerr << "open " << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms, "
+             << file->functions.size() << " functions, " << file->instructions.size() << " instructions\n";
+    }
+    Writer out(stdout);
+    file->print(out);
+    return 0;
+}
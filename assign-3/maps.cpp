@@ -0,0 +1,68 @@
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "ast.cpp"
+using namespace std;
+
+#ifndef MAPS_CPP
+#define MAPS_CPP
+
+// Type environments shared by typechecking and lowering, built once per program
+// by initializeMaps. Used by both `lower` (main.cpp) and `cflatc` (cflatc.cpp).
+
+// using ParamsReturnVal = pair<vector<Type*>, Type*>;
+// using Gamma = Scope<SymbolId, Type*>;
+// using Delta = unordered_map<SymbolId, Gamma>;
+// using Errors = vector<string>;
+// using FunctionsInfo = unordered_map<SymbolId, ParamsReturnVal>;
+// using StructFunctionsInfo = unordered_map<SymbolId, FunctionsInfo>;
+
+Gamma globals_map; // stores globals, externs, and functions
+Delta delta; // struct name to (struct decl to type)
+unordered_map<SymbolId, Gamma> locals_map; // function name to its locals (params and locals), chained to globals_map
+unordered_map<SymbolId, ParamsReturnVal> functions_map; // all functions to their funcInfo
+unordered_map<SymbolId, FunctionsInfo> struct_functions_map; // struct name to (struct decl to funcInfo)
+vector<string> errors_map;
+
+void initializeMaps(AST::Program* prog) {
+    for (AST::Decl* g: prog->globals) { 
+        globals_map[g->name] = g->type;
+        if (g->typeName().isPointerToFunction()) { functions_map[g->name] = g->funcInfo(); } // decl could be function pointer
+    }
+    for (AST::Struct* s: prog->structs) { 
+        Gamma temp_map;
+        // cout << "Adding for struct with name " << s->name;
+        for (AST::Decl* f: s->fields) {
+            temp_map[f->name] = f->type;
+            // cout << " and for field " << f->name;
+            if (f->typeName().isPointerToFunction()) {
+                struct_functions_map[s->name][f->name] = f->funcInfo(); 
+            }
+        }
+        delta[s->name] = temp_map;
+        // cout << " ... added!\n";
+    }
+
+    for (AST::Decl* e: prog->externs) { 
+        globals_map[e->name] = e->type; 
+        if (e->name != SymbolTable::Main) { functions_map[e->name] = e->funcInfo(); }
+    }
+    for (AST::Function* f: prog->functions) {
+        globals_map[f->name] = f->functionType(prog->arena); 
+        functions_map[f->name] = f->funcInfo();
+    }
+    for (AST::Function* f: prog->functions) { // Creating locals map
+        Gamma temp_map(&globals_map); // globals are looked up through the chain, not copied
+        for (AST::Decl* p: f->params) { 
+            temp_map[p->name] = p->type; 
+            if (p->typeName().isPointerToFunction()) { functions_map[p->name] = p->funcInfo(); } 
+        }
+        for (auto [decl, exp]: f->locals){ 
+            temp_map[decl->name] = decl->type; 
+            if (decl->typeName().isPointerToFunction()) { functions_map[decl->name] = decl->funcInfo(); } // decl could be function pointer
+        }
+        locals_map[f->name] = temp_map;
+    }
+}
+
+#endif
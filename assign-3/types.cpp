@@ -0,0 +1,135 @@
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../assign-1/symbol.cpp"
+using namespace std;
+
+#ifndef TYPES_CPP
+#define TYPES_CPP
+
+// The types the checker reasons about, hash-consed: each distinct type exists
+// exactly once, so two types are structurally equal exactly when they are the
+// same CanonType, and comparing them is a pointer compare. A type also gets a
+// dense id (in creation order) and is rendered once, when it is made, both as
+// the checker spells it in error messages and as the LIR spells it.
+//   Int        int              Int
+//   Any        _                _
+//   Struct(s)  s                Struct(s)
+//   Ptr(T)     &T               Ptr(T)
+//   Fn(Ps, R)  (P1, P2) -> R    Fn([P1, P2], R)
+// nil is Ptr(Any), "&_", which the checker lets stand for any pointer.
+struct CanonType {
+    enum class Tag : uint8_t { Int, Any, Struct, Ptr, Fn };
+
+    Tag tag;
+    uint32_t id;
+    SymbolId name;                   // Struct
+    const CanonType* ref = nullptr;  // Ptr: the pointee, Fn: the return type
+    vector<const CanonType*> params; // Fn
+    string text;
+    string lir;
+
+    bool isInt() const { return tag == Tag::Int; }
+    bool isAny() const { return tag == Tag::Any; }
+    bool isStruct() const { return tag == Tag::Struct; }
+    bool isPtr() const { return tag == Tag::Ptr; }
+    bool isFn() const { return tag == Tag::Fn; }
+    bool isNil() const { return tag == Tag::Ptr && ref->tag == Tag::Any; }
+};
+
+// The process-wide table of types; get it with types(). Making a type may be
+// done from several threads, and the returned pointers stay valid for good.
+struct TypeTable {
+    struct FnKey {
+        const CanonType* ret;
+        vector<const CanonType*> params;
+        bool operator==(const FnKey& other) const { return ret == other.ret && params == other.params; }
+    };
+    struct FnKeyHash {
+        size_t operator()(const FnKey& k) const noexcept {
+            size_t h = hash<const CanonType*>()(k.ret);
+            for (const CanonType* p: k.params) h = h * 31 + hash<const CanonType*>()(p);
+            return h;
+        }
+    };
+
+    mutex lock;
+    deque<CanonType> all; // by id; a deque so that growing it never moves a type
+    unordered_map<SymbolId, const CanonType*> structs;
+    unordered_map<const CanonType*, const CanonType*> ptrs; // pointee to pointer
+    unordered_map<FnKey, const CanonType*, FnKeyHash> fns;
+    const CanonType* intType;
+    const CanonType* anyType;
+    const CanonType* nilType;
+
+    TypeTable() {
+        intType = add(CanonType::Tag::Int, "int", "Int");
+        anyType = add(CanonType::Tag::Any, "_", "_");
+        nilType = ptr(anyType);
+    }
+    TypeTable(const TypeTable&) = delete;
+    TypeTable& operator=(const TypeTable&) = delete;
+
+    const CanonType* integer() const { return intType; }
+    const CanonType* any() const { return anyType; }
+    const CanonType* nil() const { return nilType; }
+
+    const CanonType* structType(SymbolId name) {
+        lock_guard<mutex> guard(lock);
+        auto it = structs.find(name);
+        if (it != structs.end()) return it->second;
+        CanonType* t = add(CanonType::Tag::Struct, name.str(), "Struct(" + name.str() + ")");
+        t->name = name;
+        return structs[name] = t;
+    }
+
+    const CanonType* ptr(const CanonType* ref) {
+        lock_guard<mutex> guard(lock);
+        auto it = ptrs.find(ref);
+        if (it != ptrs.end()) return it->second;
+        CanonType* t = add(CanonType::Tag::Ptr, "&" + ref->text, "Ptr(" + ref->lir + ")");
+        t->ref = ref;
+        return ptrs[ref] = t;
+    }
+
+    const CanonType* fn(const vector<const CanonType*>& params, const CanonType* ret) {
+        lock_guard<mutex> guard(lock);
+        FnKey key{ ret, params };
+        auto it = fns.find(key);
+        if (it != fns.end()) return it->second;
+        string text = "(", lir = "Fn([";
+        for (unsigned int i = 0; i < params.size(); i++) {
+            text += params[i]->text;
+            lir += params[i]->lir;
+            if (i != params.size() - 1) { text += ", "; lir += ", "; }
+        }
+        CanonType* t = add(CanonType::Tag::Fn, text + ") -> " + ret->text, lir + "], " + ret->lir + ")");
+        t->ref = ret;
+        t->params = params;
+        return fns[move(key)] = t;
+    }
+
+    size_t size() {
+        lock_guard<mutex> guard(lock);
+        return all.size();
+    }
+
+    CanonType* add(CanonType::Tag tag, string text, string lir) {
+        CanonType& t = all.emplace_back();
+        t.tag = tag;
+        t.id = static_cast<uint32_t>(all.size() - 1);
+        t.text = move(text);
+        t.lir = move(lir);
+        return &t;
+    }
+};
+
+inline TypeTable& types() {
+    static TypeTable table;
+    return table;
+}
+
+#endif
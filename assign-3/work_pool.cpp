@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#ifndef WORK_POOL_CPP
+#define WORK_POOL_CPP
+
+// Runs a loop body over the indices [0, n) on several threads, with work
+// stealing. Each worker starts out owning an equal slice of the indices and
+// takes them one at a time from the front. One that runs dry steals the back
+// half of the slice of another worker that still has some. Uneven work, like
+// functions of very different sizes, then evens out without an up-front guess.
+// The body gets the index and the number of the worker running it, and must be
+// safe to call concurrently for different indices. If the body throws, the
+// workers stop taking indices, and the first exception is rethrown on the
+// calling thread once they have all finished.
+struct WorkPool {
+    struct Slice {
+        mutex lock;
+        size_t begin = 0, end = 0;
+    };
+
+    unsigned threads;
+
+    explicit WorkPool(unsigned threads) : threads(max(1u, threads)) {}
+
+    template<class Body>
+    void run(size_t n, Body body) {
+        unsigned workers = static_cast<unsigned>(min<size_t>(threads, n));
+        if (workers <= 1) {
+            for (size_t i = 0; i < n; i++) body(i, 0u);
+            return;
+        }
+        unique_ptr<Slice[]> slices(new Slice[workers]);
+        for (unsigned w = 0; w < workers; w++) {
+            slices[w].begin = n * w / workers;
+            slices[w].end = n * (w + 1) / workers;
+        }
+        mutex failed_lock;
+        exception_ptr failed;
+        atomic<bool> stopped{false};
+        auto work = [&](unsigned w) {
+            Slice& own = slices[w];
+            while (true) {
+                if (stopped.load(memory_order_relaxed)) return;
+                size_t i;
+                {
+                    lock_guard<mutex> guard(own.lock);
+                    if (own.begin < own.end) i = own.begin++;
+                    else i = n;
+                }
+                if (i < n) {
+                    try {
+                        body(i, w);
+                    } catch (...) {
+                        lock_guard<mutex> guard(failed_lock);
+                        if (!failed) failed = current_exception();
+                        stopped.store(true, memory_order_relaxed);
+                    }
+                    continue;
+                }
+                if (!steal(slices.get(), workers, w)) return;
+            }
+        };
+        vector<thread> pool;
+        for (unsigned w = 1; w < workers; w++) pool.emplace_back(work, w);
+        work(0);
+        for (thread& t: pool) t.join();
+        if (failed) rethrow_exception(failed);
+    }
+
+    // Moves the back half of some other worker's slice into worker w's (empty)
+    // slice. False once no one has anything left to take.
+    static bool steal(Slice* slices, unsigned workers, unsigned w) {
+        for (unsigned k = 1; k < workers; k++) {
+            Slice& victim = slices[(w + k) % workers];
+            size_t begin, end;
+            {
+                lock_guard<mutex> guard(victim.lock);
+                if (victim.begin >= victim.end) continue;
+                end = victim.end;
+                begin = victim.begin + (victim.end - victim.begin) / 2;
+                victim.end = begin;
+            }
+            lock_guard<mutex> guard(slices[w].lock);
+            slices[w].begin = begin;
+            slices[w].end = end;
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "../assign-1/symbol.cpp"
+using namespace std;
+
+#ifndef WRITER_CPP
+#define WRITER_CPP
+
+// Text output for the large things the compiler prints, like a lowered module.
+// Everything written is gathered in a 1 MB buffer, and the buffer goes to the
+// FILE in one fwrite each time it fills, so printing costs a copy into the
+// buffer and no stream machinery. Nothing reaches the FILE before the buffer
+// fills or flush() is called (the destructor flushes), so anything else
+// written to the same FILE in the meantime would come out first.
+struct Writer {
+    static constexpr size_t Capacity = size_t(1) << 20;
+
+    FILE* file;
+    unique_ptr<char[]> buffer;
+    size_t used = 0;
+
+    explicit Writer(FILE* file) : file(file), buffer(new char[Capacity]) {}
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    ~Writer() { flush(); }
+
+    void flush() {
+        if (used > 0) fwrite(buffer.get(), 1, used, file);
+        used = 0;
+        fflush(file);
+    }
+
+    Writer& operator<<(string_view text) {
+        if (text.size() > Capacity - used) {
+            flush();
+            if (text.size() > Capacity) {
+                fwrite(text.data(), 1, text.size(), file);
+                return *this;
+            }
+        }
+        memcpy(buffer.get() + used, text.data(), text.size());
+        used += text.size();
+        return *this;
+    }
+    Writer& operator<<(const char* text) { return *this << string_view(text); }
+    Writer& operator<<(const string& text) { return *this << string_view(text); }
+    Writer& operator<<(char c) {
+        if (used == Capacity) flush();
+        buffer[used++] = c;
+        return *this;
+    }
+    Writer& operator<<(SymbolId name) { return *this << string_view(name.str()); }
+
+    // Integers in decimal, as an ostream prints them
+    template<class Int>
+    enable_if_t<is_integral_v<Int> && !is_same_v<Int, char> && !is_same_v<Int, bool>, Writer&> operator<<(Int n) {
+        if (Capacity - used < 24) flush();
+        used = to_chars(buffer.get() + used, buffer.get() + Capacity, n).ptr - buffer.get();
+        return *this;
+    }
+};
+
+#endif
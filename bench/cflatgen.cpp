@@ -0,0 +1,33 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "generator.cpp"
+
+// usage: cflatgen [--structs N] [--functions N] [--stmts N] [--depth N]
+//                 [--expr-depth N] [--pointers PCT] [--calls PCT] [--seed N]
+// Writes a random, well-typed cflat program to stdout (see generator.cpp).
+int main(int argc, char** argv) {
+    GenOptions opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        unsigned value = static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+        if (flag == "--structs") opt.structs = value;
+        else if (flag == "--functions") opt.functions = value;
+        else if (flag == "--stmts") opt.stmts = value;
+        else if (flag == "--depth") opt.depth = value;
+        else if (flag == "--expr-depth") opt.exprDepth = value;
+        else if (flag == "--pointers") opt.pointers = value;
+        else if (flag == "--calls") opt.calls = value;
+        else if (flag == "--seed") opt.seed = value;
+        else {
+            std::cerr << "Unknown option " << flag << "\n";
+            return 1;
+        }
+    }
+    if (argc % 2 == 0) {
+        std::cerr << "Missing value for " << argv[argc - 1] << "\n";
+        return 1;
+    }
+    std::cout << ProgramGenerator(opt).generate();
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <malloc.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../assign-1/pull_lexer.cpp"
+#include "../assign-3/grammar.cpp"
+#include "../assign-3/flat_ast.cpp"
+#include "../assign-3/maps.cpp"
+#include "generator.cpp"
+#include "node_count.cpp"
+
+// The pointer AST against Flat::Program on a generated program: heap bytes each
+// takes, and the time for a full pre-order walk of each (best of N rounds). Also
+// times a pass that needs no walk at all in the flat form: tallying the kinds of
+// every expression, a linear scan of one column.
+
+std::size_t heapBytes() {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd; // small allocations + mmapped ones
+}
+
+struct Counter {
+    std::size_t n = 0;
+    void type(Flat::Index) { n++; }
+    void exp(Flat::Index) { n++; }
+    void lval(Flat::Index) { n++; }
+    void rhs(Flat::Index) { n++; }
+    void stmt(Flat::Index) { n++; }
+    void decl(Flat::Index) { n++; }
+    void structDef(Flat::Index) { n++; }
+    void function(Flat::Index) { n++; }
+};
+
+// Same tally over the pointer tree, which has to walk to find the expressions
+struct ExpTally {
+    std::size_t kinds[32] = {};
+    void exp(const Exp* e) {
+        kinds[static_cast<int>(e->kind)]++;
+        if (auto u = dyn_cast<UnOp>(e)) exp(u->operand);
+        else if (auto b = dyn_cast<BinOp>(e)) { exp(b->left); exp(b->right); }
+        else if (auto a = dyn_cast<ExpArrayAccess>(e)) { exp(a->ptr); exp(a->index); }
+        else if (auto f = dyn_cast<ExpFieldAccess>(e)) exp(f->ptr);
+        else if (auto c = dyn_cast<ExpCall>(e)) {
+            exp(c->callee);
+            for (const Exp* arg: c->args) exp(arg);
+        }
+    }
+    void lval(const Lval* l) {
+        if (auto d = dyn_cast<LvalDeref>(l)) lval(d->lval);
+        else if (auto a = dyn_cast<LvalArrayAccess>(l)) { lval(a->ptr); exp(a->index); }
+        else if (auto f = dyn_cast<LvalFieldAccess>(l)) lval(f->ptr);
+    }
+    void stmts(const std::vector<Stmt*>& ss) {
+        for (const Stmt* s: ss) {
+            if (auto a = dyn_cast<Assign>(s)) {
+                lval(a->lhs);
+                if (auto r = dyn_cast<RhsExp>(a->rhs)) exp(r->exp);
+                else exp(cast<New>(a->rhs)->amount);
+            }
+            else if (auto c = dyn_cast<StmtCall>(s)) {
+                lval(c->callee);
+                for (const Exp* arg: c->args) exp(arg);
+            }
+            else if (auto i = dyn_cast<If>(s)) { exp(i->guard); stmts(i->tt); stmts(i->ff); }
+            else if (auto w = dyn_cast<While>(s)) { exp(w->guard); stmts(w->body); }
+            else if (auto r = dyn_cast<Return>(s)) exp(r->exp);
+        }
+    }
+    void program(const Program* prog) {
+        for (const Function* f: prog->functions) {
+            for (const auto& local: f->locals) exp(local.second);
+            stmts(f->stmts);
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    GenOptions opt;
+    opt.functions = (argc > 1) ? std::stoul(argv[1]) : 4000;
+    int rounds = (argc > 2) ? std::stoi(argv[2]) : 5;
+    const std::string source = ProgramGenerator(opt).generate();
+
+    std::vector<Token> tokens;
+    Lexer lexer(source);
+    for (Token t = lexer.next(); t.kind != TokenKind::End; t = lexer.next()) tokens.push_back(t);
+    Grammar g;
+    g.tokens = TokenCursor(std::move(tokens));
+    std::size_t before = heapBytes();
+    Program* prog = g.program(0);
+    std::size_t treeBytes = heapBytes() - before;
+
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::time_point since) { return std::chrono::duration<double>(Clock::now() - since).count(); };
+    before = heapBytes();
+    Clock::time_point start = Clock::now();
+    Flat::Program flat = Flat::flatten(*prog);
+    double flattenTime = seconds(start);
+    std::size_t flatBytes = heapBytes() - before;
+
+    double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+    std::size_t treeNodes = 0, flatNodes = 0, treeExps = 0, flatExps = 0;
+    for (int r = 0; r < rounds; r++) {
+        start = Clock::now();
+        treeNodes = countNodes(prog);
+        best[0] = std::min(best[0], seconds(start));
+
+        start = Clock::now();
+        Counter counter;
+        flat.walk(counter);
+        flatNodes = counter.n + 1; // and the Program
+        best[1] = std::min(best[1], seconds(start));
+
+        start = Clock::now();
+        ExpTally tally;
+        tally.program(prog);
+        treeExps = 0;
+        for (std::size_t k: tally.kinds) treeExps += k;
+        best[2] = std::min(best[2], seconds(start));
+
+        start = Clock::now();
+        std::size_t kinds[32] = {};
+        for (AST::Kind k: flat.exps.kind) kinds[static_cast<int>(k)]++;
+        flatExps = 0;
+        for (std::size_t k: kinds) flatExps += k;
+        best[3] = std::min(best[3], seconds(start));
+    }
+    if (treeNodes != flatNodes) std::cerr << "warning: node counts differ: tree " << treeNodes << ", flat " << flatNodes << "\n";
+    if (treeExps != flatExps) std::cerr << "warning: expression counts differ: tree " << treeExps << ", flat " << flatExps << "\n";
+
+    std::cout << "program: " << source.size() / 1024 << " KB, " << prog->functions.size() << " functions, "
+              << treeNodes << " nodes\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "memory   tree " << treeBytes / 1024 << " KB (" << double(treeBytes) / treeNodes << " B/node), flat "
+              << flatBytes / 1024 << " KB (" << double(flatBytes) / flatNodes << " B/node, " << flat.bytes() / 1024 << " KB in tables)\n";
+    std::cout << "flatten  " << std::setprecision(2) << flattenTime * 1000 << " ms\n";
+    const char* names[] = { "walk     tree", "walk     flat", "exp scan tree", "exp scan flat" };
+    const std::size_t counts[] = { treeNodes, flatNodes, treeExps, flatExps };
+    for (int i = 0; i < 4; i++) {
+        std::cout << names[i] << std::setw(10) << std::setprecision(2) << best[i] * 1000 << " ms  "
+                  << std::setprecision(0) << std::setw(12) << counts[i] / best[i] << " nodes/s\n";
+    }
+    delete prog;
+    return 0;
+}
@@ -0,0 +1,227 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef GENERATOR_CPP
+#define GENERATOR_CPP
+
+// Generates random cflat programs (grammar-3.md) that parse and typecheck cleanly,
+// for throughput benchmarks. The output is deterministic for a given seed.
+//
+// Every program has the same skeleton: structs S0..Sn-1 (each with two int
+// fields, a self pointer `next` and a pointer `link` to the next struct), three
+// externs, a few globals, functions f0..fm-1 returning int, and main. Function
+// bodies are random statements built over typed locals so that every expression
+// is well-typed by construction.
+struct GenOptions {
+    unsigned structs = 4;    // struct definitions
+    unsigned functions = 16; // functions besides main
+    unsigned stmts = 12;     // statements per block at the top of a function body
+    unsigned depth = 2;      // max nesting of if/while
+    unsigned exprDepth = 3;  // max nesting of binary/unary operators
+    unsigned pointers = 30;  // % of operands/assignments that go through pointers (deref, [], field)
+    unsigned calls = 15;     // % of operands that are function calls
+    unsigned seed = 1;
+};
+
+struct ProgramGenerator {
+    // Parameter/local types: int, &int, or &S<k>
+    struct Var { std::string name; int type; }; // type: -2 int, -1 &int, k >= 0 &Sk
+    struct Signature { std::vector<int> params; };
+
+    GenOptions opt;
+    std::mt19937 rng;
+    std::vector<Signature> sigs;
+    std::vector<Var> vars;  // in scope in the current function
+    unsigned loops = 0;     // enclosing while loops
+    std::string out;
+
+    explicit ProgramGenerator(const GenOptions& options) : opt(options), rng(options.seed) {
+        if (opt.structs == 0) opt.structs = 1; // struct pointer types are drawn from S0..
+    }
+
+    unsigned pick(unsigned n) { return static_cast<unsigned>(rng() % n); }
+    bool chance(unsigned percent) { return pick(100) < percent; }
+    std::string structName(int k) const { return "S" + std::to_string(k); }
+    std::string typeName(int type) const { return type == -2 ? "int" : type == -1 ? "&int" : "&" + structName(type); }
+
+    std::vector<const Var*> varsOf(int type) const {
+        std::vector<const Var*> vs;
+        for (const Var& v: vars) if (v.type == type) vs.push_back(&v);
+        return vs;
+    }
+    const Var* anyVarOf(int type) {
+        std::vector<const Var*> vs = varsOf(type);
+        return vs.empty() ? nullptr : vs[pick(vs.size())];
+    }
+
+    // Pointer-valued expressions
+    std::string ptrExp(int type, unsigned depth) {
+        const Var* v = anyVarOf(type);
+        if (type >= 0 && v && depth > 0 && chance(opt.pointers)) {
+            // s.next is &S<k>; s.link of an &S<k-1> is &S<k>
+            if (chance(50)) return ptrExp(type, depth - 1) + ".next";
+            int prev = (type + opt.structs - 1) % opt.structs;
+            if (anyVarOf(prev)) return ptrExp(prev, depth - 1) + ".link";
+        }
+        if (type == -1 && depth > 0 && chance(opt.calls)) return "alloc(" + intExp(depth - 1) + ")";
+        return v ? v->name : "nil";
+    }
+
+    // A call returning int: one of the f<i>, or the extern mix if there are none
+    std::string call(unsigned depth) {
+        if (sigs.empty()) return "mix(" + intExp(depth) + ", " + intExp(depth) + ")";
+        unsigned f = pick(sigs.size());
+        std::string s = "f" + std::to_string(f) + "(";
+        for (std::size_t i = 0; i < sigs[f].params.size(); i++) {
+            if (i) s += ", ";
+            int type = sigs[f].params[i];
+            s += (type == -2) ? intExp(depth) : ptrExp(type, depth);
+        }
+        return s + ")";
+    }
+
+    std::string intOperand(unsigned depth) {
+        if (depth > 0 && chance(opt.calls)) return call(depth - 1);
+        if (chance(opt.pointers)) {
+            switch (pick(3)) {
+                case 0: if (anyVarOf(-1)) return "*" + ptrExp(-1, depth); break;
+                case 1: if (anyVarOf(-1)) return ptrExp(-1, depth) + "[" + intExp(depth > 0 ? depth - 1 : 0) + "]"; break;
+                default: {
+                    int k = pick(opt.structs);
+                    if (anyVarOf(k)) return ptrExp(k, depth) + (chance(50) ? ".v" : ".w");
+                }
+            }
+        }
+        const Var* v = anyVarOf(-2);
+        if (v && chance(60)) return v->name;
+        if (chance(10)) return "g0";
+        return std::to_string(pick(1000));
+    }
+
+    std::string intExp(unsigned depth) {
+        if (depth == 0 || chance(30)) return intOperand(depth);
+        static const char* const ops[] = { " + ", " - ", " * ", " / " };
+        switch (pick(5)) {
+            case 0: return "-" + intOperand(depth - 1);
+            case 1: return "(" + intExp(depth - 1) + ops[pick(4)] + intExp(depth - 1) + ")";
+            default: return intExp(depth - 1) + ops[pick(4)] + intOperand(depth - 1);
+        }
+    }
+
+    std::string guard(unsigned depth) {
+        static const char* const cmps[] = { " < ", " <= ", " > ", " >= ", " == ", " != " };
+        int k = pick(opt.structs);
+        if (chance(opt.pointers / 2) && anyVarOf(k)) return ptrExp(k, depth) + (chance(50) ? " != nil" : " == nil");
+        return intExp(depth) + cmps[pick(6)] + intExp(depth);
+    }
+
+    // An assignable place of int type
+    std::string intLval(unsigned depth) {
+        if (chance(opt.pointers)) {
+            switch (pick(3)) {
+                case 0: if (const Var* p = anyVarOf(-1)) return "*" + p->name; break;
+                case 1: if (const Var* p = anyVarOf(-1)) return p->name + "[" + intExp(depth) + "]"; break;
+                default: {
+                    int k = pick(opt.structs);
+                    if (const Var* s = anyVarOf(k)) return s->name + (chance(50) ? ".next.v" : ".w");
+                }
+            }
+        }
+        const Var* v = anyVarOf(-2);
+        return v ? v->name : "g0";
+    }
+
+    void indent(unsigned level) { out.append(2 * level, ' '); }
+
+    void stmt(unsigned level, unsigned nest) {
+        indent(level);
+        unsigned kind = pick(20);
+        if (kind < 2 && nest < opt.depth) {
+            out += "if " + guard(opt.exprDepth) + " {\n";
+            block(level + 1, nest + 1, 1 + pick(opt.stmts / 2 + 1));
+            indent(level);
+            if (chance(50)) {
+                out += "} else {\n";
+                block(level + 1, nest + 1, 1 + pick(opt.stmts / 2 + 1));
+                indent(level);
+            }
+            out += "}\n";
+        }
+        else if (kind < 4 && nest < opt.depth) {
+            const Var* i = anyVarOf(-2);
+            std::string counter = i ? i->name : "g0";
+            out += "while " + counter + " < " + std::to_string(1 + pick(100)) + " {\n";
+            loops++;
+            block(level + 1, nest + 1, 1 + pick(opt.stmts / 2 + 1));
+            loops--;
+            indent(level + 1);
+            out += counter + " = " + counter + " + 1;\n";
+            indent(level);
+            out += "}\n";
+        }
+        else if (kind == 4 && loops > 0) out += chance(50) ? "break;\n" : "continue;\n";
+        else if (kind == 5 && nest > 0) out += "return " + intExp(opt.exprDepth) + ";\n";
+        else if (kind < 8 && chance(opt.calls * 2)) out += chance(50) ? call(opt.exprDepth) + ";\n" : "print(" + intExp(opt.exprDepth) + ");\n";
+        else if (kind < 11 && chance(opt.pointers * 2)) {
+            int type = static_cast<int>(pick(opt.structs + 1)) - 1;
+            const Var* p = anyVarOf(type);
+            if (!p) out += intLval(opt.exprDepth) + " = " + intExp(opt.exprDepth) + ";\n";
+            else if (type == -1) out += p->name + " = new int " + intExp(opt.exprDepth) + ";\n";
+            else if (chance(50)) out += p->name + " = new " + structName(type) + ";\n";
+            else out += p->name + ".next = " + ptrExp(type, opt.exprDepth) + ";\n";
+        }
+        else out += intLval(opt.exprDepth) + " = " + intExp(opt.exprDepth) + ";\n";
+    }
+
+    void block(unsigned level, unsigned nest, unsigned count) {
+        for (unsigned i = 0; i < count; i++) stmt(level, nest);
+    }
+
+    void function(const std::string& name, const std::vector<int>& params) {
+        vars.clear();
+        out += "fn " + name + "(";
+        for (std::size_t i = 0; i < params.size(); i++) {
+            Var v{ "a" + std::to_string(i), params[i] };
+            if (i) out += ", ";
+            out += v.name + ": " + typeName(v.type);
+            vars.push_back(v);
+        }
+        out += ") -> int {\n";
+        // Locals: a few ints (the first two initialized), an &int and a pointer per struct
+        std::vector<Var> locals;
+        for (unsigned i = 0; i < 3; i++) locals.push_back(Var{ "x" + std::to_string(i), -2 });
+        locals.push_back(Var{ "p", -1 });
+        for (unsigned k = 0; k < opt.structs; k++) locals.push_back(Var{ "s" + std::to_string(k), static_cast<int>(k) });
+        out += "  let ";
+        for (std::size_t i = 0; i < locals.size(); i++) {
+            if (i) out += ", ";
+            out += locals[i].name + ": " + typeName(locals[i].type);
+            if (i < 2) out += " = " + std::to_string(pick(100));
+            vars.push_back(locals[i]);
+        }
+        out += ";\n";
+        block(1, 0, opt.stmts);
+        out += "  return " + intExp(opt.exprDepth) + ";\n}\n\n";
+    }
+
+    std::string generate() {
+        out.clear();
+        for (unsigned k = 0; k < opt.structs; k++) {
+            out += "struct " + structName(k) + " { v: int, w: int, next: &" + structName(k) +
+                   ", link: &" + structName((k + 1) % opt.structs) + " }\n";
+        }
+        out += "extern print: (int) -> _;\nextern alloc: (int) -> &int;\nextern mix: (int, int) -> int;\n";
+        out += "let g0: int, gp: &int;\n\n";
+        sigs.assign(opt.functions, Signature());
+        for (Signature& s: sigs) {
+            unsigned n = pick(4);
+            for (unsigned i = 0; i < n; i++) s.params.push_back(chance(opt.pointers) ? static_cast<int>(pick(opt.structs + 1)) - 1 : -2);
+        }
+        for (unsigned f = 0; f < opt.functions; f++) function("f" + std::to_string(f), sigs[f].params);
+        function("main", {});
+        return out;
+    }
+};
+
+#endif
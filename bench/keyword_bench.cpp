@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../assign-1/lexer.cpp"
+
+// Compares keyword classification strategies on an identifier-heavy corpus:
+//   map      - the original substr + unordered_map<string, string> lookup
+//   perfect  - keywordKind() on a string_view of the input buffer
+
+struct Span { std::size_t start, length; };
+
+std::string makeCorpus(std::size_t words, unsigned seed) {
+    static const char* const keywords[] = { "int", "struct", "nil", "break", "continue", "return", "if",
+                                            "else", "while", "new", "let", "extern", "fn" };
+    std::mt19937 rng(seed);
+    std::string corpus;
+    for (std::size_t w = 0; w < words; w++) {
+        if (rng() % 4 == 0) corpus += keywords[rng() % 13];
+        else {
+            static const char alnum[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+            corpus += alnum[rng() % 52];
+            std::size_t length = rng() % 10;
+            for (std::size_t i = 0; i < length; i++) corpus += alnum[rng() % 62];
+        }
+        corpus += ' ';
+    }
+    return corpus;
+}
+
+std::vector<Span> findIdentifiers(const std::string& input) {
+    std::vector<Span> spans;
+    Lexer lexer(input);
+    for (Token t = lexer.next(); t.kind != TokenKind::End; t = lexer.next()) {
+        spans.push_back(Span{ static_cast<std::size_t>(t.text.data() - input.data()), t.text.size() });
+    }
+    return spans;
+}
+
+template <typename F>
+double timeIt(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    std::size_t words = (argc > 1) ? std::stoul(argv[1]) : 2000000;
+    int rounds = (argc > 2) ? std::stoi(argv[2]) : 5;
+    const std::string input = makeCorpus(words, 160);
+    const std::vector<Span> spans = findIdentifiers(input);
+
+    static const std::unordered_map<std::string, std::string> tokenMap = {
+        {"int", "Int"}, {"struct", "Struct"}, {"nil", "Nil"}, {"break", "Break"},
+        {"continue", "Continue"}, {"return", "Return"}, {"if", "If"}, {"else", "Else"},
+        {"while", "While"}, {"new", "New"}, {"let", "Let"}, {"extern", "Extern"}, {"fn", "Fn"}
+    };
+
+    double bestMap = 1e30, bestPerfect = 1e30;
+    std::size_t mapKeywords = 0, perfectKeywords = 0;
+    for (int r = 0; r < rounds; r++) {
+        bestMap = std::min(bestMap, timeIt([&] {
+            mapKeywords = 0;
+            for (const Span& s: spans) {
+                auto it = tokenMap.find(input.substr(s.start, s.length));
+                std::string token = (it == tokenMap.end()) ? "Id" : it->second;
+                if (token != "Id") mapKeywords++;
+            }
+        }));
+        bestPerfect = std::min(bestPerfect, timeIt([&] {
+            perfectKeywords = 0;
+            const std::string_view view(input);
+            for (const Span& s: spans) {
+                if (keywordKind(view.substr(s.start, s.length)) != TokenKind::Id) perfectKeywords++;
+            }
+        }));
+    }
+    if (mapKeywords != perfectKeywords) {
+        std::cerr << "keyword counts disagree: " << mapKeywords << " vs " << perfectKeywords << "\n";
+        return 1;
+    }
+
+    std::cout << spans.size() << " identifiers, " << perfectKeywords << " keywords, best of " << rounds << "\n";
+    std::cout << "  map      " << bestMap * 1e9 / spans.size() << " ns/ident\n";
+    std::cout << "  perfect  " << bestPerfect * 1e9 / spans.size() << " ns/ident"
+              << " (" << bestMap / bestPerfect << "x)\n";
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <cstddef>
+#include <vector>
+#include "../assign-3/ast.cpp"
+
+#ifndef NODE_COUNT_CPP
+#define NODE_COUNT_CPP
+
+// Number of nodes in a parsed program: every Type, Exp, Lval, Rhs, Stmt, Decl,
+// Struct and Function, plus the Program itself. Operators are not nodes.
+std::size_t countNodes(const Type* t) {
+    if (auto fn = dyn_cast<Fn>(t)) {
+        std::size_t n = 1 + countNodes(fn->ret);
+        for (const Type* p: fn->prms) n += countNodes(p);
+        return n;
+    }
+    if (auto ptr = dyn_cast<Ptr>(t)) return 1 + countNodes(ptr->ref);
+    return 1;
+}
+std::size_t countNodes(const Exp* e) {
+    if (auto u = dyn_cast<UnOp>(e)) return 1 + countNodes(u->operand);
+    if (auto b = dyn_cast<BinOp>(e)) return 1 + countNodes(b->left) + countNodes(b->right);
+    if (auto a = dyn_cast<ExpArrayAccess>(e)) return 1 + countNodes(a->ptr) + countNodes(a->index);
+    if (auto f = dyn_cast<ExpFieldAccess>(e)) return 1 + countNodes(f->ptr);
+    if (auto c = dyn_cast<ExpCall>(e)) {
+        std::size_t n = 1 + countNodes(c->callee);
+        for (const Exp* arg: c->args) n += countNodes(arg);
+        return n;
+    }
+    return 1;
+}
+std::size_t countNodes(const Lval* l) {
+    if (auto d = dyn_cast<LvalDeref>(l)) return 1 + countNodes(d->lval);
+    if (auto a = dyn_cast<LvalArrayAccess>(l)) return 1 + countNodes(a->ptr) + countNodes(a->index);
+    if (auto f = dyn_cast<LvalFieldAccess>(l)) return 1 + countNodes(f->ptr);
+    return 1;
+}
+std::size_t countNodes(const std::vector<Stmt*>& stmts);
+std::size_t countNodes(const Stmt* s) {
+    if (auto a = dyn_cast<Assign>(s)) {
+        std::size_t n = 2 + countNodes(a->lhs); // the Assign and its Rhs
+        if (auto r = dyn_cast<RhsExp>(a->rhs)) return n + countNodes(r->exp);
+        auto alloc = cast<New>(a->rhs);
+        return n + countNodes(alloc->type) + countNodes(alloc->amount);
+    }
+    if (auto c = dyn_cast<StmtCall>(s)) {
+        std::size_t n = 1 + countNodes(c->callee);
+        for (const Exp* arg: c->args) n += countNodes(arg);
+        return n;
+    }
+    if (auto i = dyn_cast<If>(s)) return 1 + countNodes(i->guard) + countNodes(i->tt) + countNodes(i->ff);
+    if (auto w = dyn_cast<While>(s)) return 1 + countNodes(w->guard) + countNodes(w->body);
+    if (auto r = dyn_cast<Return>(s)) return 1 + countNodes(r->exp);
+    return 1;
+}
+std::size_t countNodes(const std::vector<Stmt*>& stmts) {
+    std::size_t n = 0;
+    for (const Stmt* s: stmts) n += countNodes(s);
+    return n;
+}
+std::size_t countNodes(const Decl* d) { return 1 + countNodes(d->type); }
+std::size_t countNodes(const Program* prog) {
+    std::size_t n = 1;
+    for (const Decl* d: prog->globals) n += countNodes(d);
+    for (const Decl* d: prog->externs) n += countNodes(d);
+    for (const Struct* s: prog->structs) {
+        n++;
+        for (const Decl* d: s->fields) n += countNodes(d);
+    }
+    for (const Function* f: prog->functions) {
+        n += 1 + countNodes(f->rettyp) + countNodes(f->stmts);
+        for (const Decl* d: f->params) n += countNodes(d);
+        for (const auto& [d, e]: f->locals) n += countNodes(d) + countNodes(e);
+    }
+    return n;
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../assign-1/pull_lexer.cpp"
+#include "../assign-3/grammar.cpp"
+#include "../assign-3/lir.cpp"
+#include "../assign-3/maps.cpp"
+#include "generator.cpp"
+#include "node_count.cpp"
+
+// Per-phase throughput of the assign-3 pipeline on a generated program:
+// lexing (tokens/s), Grammar::program (AST nodes/s), Program::typeCheck
+// (functions/s), LIR::Program (LIR instructions/s) and freeing the AST
+// (AST nodes/s). Best of N rounds.
+//   pipeline_bench [functions] [rounds] [threads]
+// threads is passed on to Program::typeCheck and LIR::Program.
+
+std::size_t countInstructions(const LIR::Program& lir) {
+    std::size_t n = 0;
+    for (const auto& [name, function]: lir.function_map) n += function.size();
+    return n;
+}
+
+void resetMaps() {
+    globals_map.clear();
+    delta.clear();
+    locals_map.clear();
+    functions_map.clear();
+    struct_functions_map.clear();
+    errors_map.clear();
+}
+
+int main(int argc, char** argv) {
+    GenOptions opt;
+    opt.functions = (argc > 1) ? std::stoul(argv[1]) : 2000;
+    int rounds = (argc > 2) ? std::stoi(argv[2]) : 3;
+    unsigned threads = (argc > 3) ? static_cast<unsigned>(std::max(1, std::stoi(argv[3]))) : 1;
+    const std::string source = ProgramGenerator(opt).generate();
+
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::time_point since) { return std::chrono::duration<double>(Clock::now() - since).count(); };
+    double best[5] = { 1e30, 1e30, 1e30, 1e30, 1e30 };
+    std::size_t tokenCount = 0, nodes = 0, functions = 0, instructions = 0;
+    for (int r = 0; r < rounds; r++) {
+        resetMaps();
+        Clock::time_point start = Clock::now();
+        std::vector<Token> tokens;
+        Lexer lexer(source);
+        for (Token t = lexer.next(); t.kind != TokenKind::End; t = lexer.next()) tokens.push_back(t);
+        best[0] = std::min(best[0], seconds(start));
+        tokenCount = tokens.size();
+
+        start = Clock::now();
+        Grammar g;
+        g.tokens = TokenCursor(std::move(tokens));
+        Program* prog = g.program(0);
+        best[1] = std::min(best[1], seconds(start));
+        nodes = countNodes(prog);
+
+        start = Clock::now();
+        initializeMaps(prog);
+        prog->typeCheck(globals_map, errors_map, locals_map, threads);
+        best[2] = std::min(best[2], seconds(start));
+        functions = prog->functions.size();
+        if (!errors_map.empty()) std::cerr << "warning: generated program has " << errors_map.size() << " type errors, e.g. " << errors_map[0] << "\n";
+
+        start = Clock::now();
+        LIR::Program lir(prog, locals_map, threads);
+        best[3] = std::min(best[3], seconds(start));
+        instructions = countInstructions(lir);
+
+        start = Clock::now();
+        delete prog;
+        best[4] = std::min(best[4], seconds(start));
+    }
+
+    std::cout << "program: " << source.size() / 1024 << " KB, " << functions << " functions, typecheck and lowering on " << threads << " threads\n";
+    const char* phases[] = { "lex", "parse", "typecheck", "lower", "free" };
+    const char* units[] = { "tokens", "AST nodes", "functions", "LIR instrs", "AST nodes" };
+    const std::size_t counts[] = { tokenCount, nodes, functions, instructions, nodes };
+    for (int i = 0; i < 5; i++) {
+        std::cout << std::left << std::setw(10) << phases[i] << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(9) << best[i] * 1000 << " ms  " << std::setw(10) << counts[i] << " " << std::setw(10) << std::left << units[i]
+                  << std::right << std::setprecision(0) << std::setw(12) << counts[i] / best[i] << " /s\n";
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../assign-1/lexer.cpp"
+
+// Lexer throughput in MB/s with each set of run-skipping kernels from scan.cpp,
+// on synthetic corpora dominated by comments, whitespace and identifiers.
+
+std::string makeCorpus(const std::string& shape, std::size_t bytes, unsigned seed) {
+    std::mt19937 rng(seed);
+    static const char* const code[] = { "let x: int = y + 42;", "fn f(a: &int) -> int {", "}", "p.next = q[3];", "while i < n {" };
+    static const char alnum[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    std::string corpus;
+    while (corpus.size() < bytes) {
+        if (shape == "comment") {
+            corpus += (rng() % 2) ? "// " : "/* ";
+            std::size_t length = 40 + rng() % 120;
+            for (std::size_t i = 0; i < length; i++) corpus += (rng() % 6 == 0) ? ' ' : alnum[rng() % 62];
+            corpus += (corpus[corpus.size() - length - 2] == '/') ? "\n" : " */\n";
+            corpus += code[rng() % 5];
+            corpus += '\n';
+        }
+        else if (shape == "whitespace") {
+            corpus.append(8 + rng() % 64, ' ');
+            corpus += code[rng() % 5];
+            corpus.append(1 + rng() % 4, '\n');
+            corpus.append(rng() % 8, '\t');
+        }
+        else {
+            corpus += alnum[rng() % 52];
+            std::size_t length = 4 + rng() % 24;
+            for (std::size_t i = 0; i < length; i++) corpus += alnum[rng() % 62];
+            corpus += (rng() % 4) ? " " : ".";
+        }
+    }
+    return corpus;
+}
+
+struct Result { std::size_t tokens = 0; std::size_t checksum = 0; };
+
+Result lexAll(const std::string& input, const scan::Kernels& kernels) {
+    Result r;
+    Lexer lexer(input);
+    lexer.kernels = &kernels;
+    for (Token t = lexer.scan(); t.kind != TokenKind::End; t = lexer.scan()) {
+        r.tokens++;
+        r.checksum += static_cast<std::size_t>(t.kind) * 31 + t.text.size();
+    }
+    return r;
+}
+
+int main(int argc, char** argv) {
+    std::size_t megabytes = (argc > 1) ? std::stoul(argv[1]) : 64;
+    int rounds = (argc > 2) ? std::stoi(argv[2]) : 3;
+
+    std::vector<const scan::Kernels*> sets = { &scan::scalarKernels };
+#ifdef SCAN_X86
+    sets.push_back(&scan::sse2Kernels);
+    if (__builtin_cpu_supports("avx2")) sets.push_back(&scan::avx2Kernels);
+#endif
+    std::cout << "runtime choice: " << scan::best().name << "\n";
+
+    for (const std::string shape: { "comment", "whitespace", "identifier" }) {
+        const std::string input = makeCorpus(shape, megabytes << 20, 160);
+        std::cout << shape << " corpus, " << input.size() / double(1 << 20) << " MB\n";
+        Result expected;
+        for (const scan::Kernels* k: sets) {
+            double best = 1e30;
+            Result r;
+            for (int i = 0; i < rounds; i++) {
+                auto start = std::chrono::steady_clock::now();
+                r = lexAll(input, *k);
+                best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+            if (k == sets.front()) expected = r;
+            else if (r.tokens != expected.tokens || r.checksum != expected.checksum) {
+                std::cerr << k->name << " disagrees with scalar on the " << shape << " corpus\n";
+                return 1;
+            }
+            std::cout << "  " << k->name << "\t" << input.size() / best / (1 << 20) << " MB/s\n";
+        }
+    }
+    return 0;
+}